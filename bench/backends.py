@@ -0,0 +1,152 @@
+#
+# Copyright (c) 2009 - 2013 Malek Hadj-Ali
+# All rights reserved.
+#
+# This file is part of pyev.
+#
+# pyev is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 3
+# as published by the Free Software Foundation.
+#
+# pyev is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with pyev.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+
+"""Run the same Io/Timer workload on every available backend.
+
+Every backend gets FDS socket pairs with an Io watcher on one end of each, and
+TIMERS repeating timers. Every TICK seconds a driver timer writes one byte to
+ACTIVE randomly chosen pairs, the latency is measured from the write to the Io
+callback.
+
+usage: python bench/backends.py [--fds N] [--active N] [--timers N]
+                                [--tick SECONDS] [--duration SECONDS]
+"""
+
+
+from __future__ import print_function
+
+import argparse
+import os
+import random
+import socket
+import time
+
+import pyev
+
+
+clock = getattr(time, "perf_counter", time.time)
+
+
+BACKENDS = ["SELECT", "POLL", "EPOLL", "KQUEUE", "DEVPOLL", "PORT",
+            "LINUXAIO", "IOURING"]
+
+
+class Workload(object):
+
+    def __init__(self, loop, args):
+        self.loop = loop
+        self.args = args
+        self.events = 0
+        self.latencies = []
+        self.sent = {}
+        self.pairs = []
+        self.watchers = []
+        for i in range(args.fds):
+            a, b = socket.socketpair()
+            a.setblocking(False)
+            b.setblocking(False)
+            self.pairs.append((a, b))
+            self.watchers.append(loop.io(a, pyev.EV_READ, self.io_cb, b))
+        for i in range(args.timers):
+            self.watchers.append(loop.timer(0, args.tick, self.timer_cb))
+        self.watchers.append(loop.timer(0, args.tick, self.drive_cb))
+        self.watchers.append(loop.timer(args.duration, 0, self.stop_cb))
+
+    def io_cb(self, watcher, revents):
+        os.read(watcher.fd, 4096)
+        self.latencies.append(clock() - self.sent.pop(watcher.fd))
+        self.events += 1
+
+    def timer_cb(self, watcher, revents):
+        self.events += 1
+
+    def drive_cb(self, watcher, revents):
+        self.events += 1
+        for a, b in random.sample(self.pairs, self.args.active):
+            fd = a.fileno()
+            if fd not in self.sent:
+                self.sent[fd] = clock()
+                b.send(b"x")
+
+    def stop_cb(self, watcher, revents):
+        self.loop.stop(pyev.EVBREAK_ALL)
+
+    def run(self):
+        for watcher in self.watchers:
+            watcher.start()
+        start = clock()
+        self.loop.start()
+        elapsed = clock() - start
+        for watcher in self.watchers:
+            watcher.stop()
+        for a, b in self.pairs:
+            a.close()
+            b.close()
+        return elapsed
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+def available_backends():
+    supported = pyev.supported_backends()
+    for name in BACKENDS:
+        flag = getattr(pyev, "EVBACKEND_" + name, 0)
+        if flag and (flag & supported or name in ("LINUXAIO", "IOURING")):
+            yield name, flag
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--fds", type=int, default=1000)
+    parser.add_argument("--active", type=int, default=100)
+    parser.add_argument("--timers", type=int, default=100)
+    parser.add_argument("--tick", type=float, default=0.001)
+    parser.add_argument("--duration", type=float, default=5.0)
+    args = parser.parse_args()
+    args.active = min(args.active, args.fds)
+
+    print("{0:>10} {1:>12} {2:>12} {3:>12}".format("backend", "events/sec",
+                                                   "p50 (us)", "p99 (us)"))
+    for name, flag in available_backends():
+        try:
+            # EVFLAG_NOENV: don't let LIBEV_FLAGS pick another backend
+            loop = pyev.Loop(flag | pyev.EVFLAG_NOENV)
+        except pyev.Error:
+            # not usable here (kernel too old, not enough resources...)
+            print("{0:>10} {1:>12}".format(name, "unavailable"))
+            continue
+        if loop.backend != flag:
+            print("{0:>10} {1:>12}".format(name, "unavailable"))
+            continue
+        workload = Workload(loop, args)
+        elapsed = workload.run()
+        print("{0:>10} {1:>12.0f} {2:>12.1f} {3:>12.1f}".format(
+              name, workload.events / elapsed,
+              percentile(workload.latencies, 50) * 1e6,
+              percentile(workload.latencies, 99) * 1e6))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,150 @@
+#
+# Copyright (c) 2009 - 2013 Malek Hadj-Ali
+# All rights reserved.
+#
+# This file is part of pyev.
+#
+# pyev is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 3
+# as published by the Free Software Foundation.
+#
+# pyev is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with pyev.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+
+"""Stress pyev with several loops running in parallel.
+
+For every thread count up to THREADS, a LoopGroup runs PAIRS socket pairs per
+loop bouncing a byte back and forth, while SUBMITTERS threads keep submitting
+callables to the group. Every submitted callable must run exactly once.
+
+On a free-threaded Python, events/sec should grow with the number of threads.
+
+usage: python bench/threads.py [--threads N] [--pairs N] [--submitters N]
+                               [--duration SECONDS]
+"""
+
+
+from __future__ import print_function
+
+import argparse
+import socket
+import sys
+import threading
+import time
+
+import pyev
+
+
+clock = getattr(time, "perf_counter", time.time)
+
+
+class PingPong(object):
+
+    def __init__(self, loop, pairs):
+        self.events = 0
+        self.sockets = []
+        self.watchers = []
+        for i in range(pairs):
+            a, b = socket.socketpair()
+            a.setblocking(False)
+            b.setblocking(False)
+            self.sockets.extend((a, b))
+            for s in (a, b):
+                watcher = loop.io(s, pyev.EV_READ, self.io_cb, s)
+                watcher.start()
+                self.watchers.append(watcher)
+            a.send(b"x")
+
+    def io_cb(self, watcher, revents):
+        watcher.data.recv(1)
+        watcher.data.send(b"x")
+        self.events += 1
+
+    def close(self):
+        for watcher in self.watchers:
+            watcher.stop()
+        for s in self.sockets:
+            s.close()
+
+
+def run(args, threads):
+    group = pyev.LoopGroup(threads)
+    pingpongs = [None] * threads
+    done = []
+    ready = threading.Semaphore(0)
+
+    def setup(loop):
+        pingpongs[group.loops.index(loop)] = PingPong(loop, args.pairs)
+        ready.release()
+
+    def teardown(loop):
+        pingpongs[group.loops.index(loop)].close()
+        ready.release()
+
+    def job(loop):
+        done.append(1)
+
+    submitted = [0] * args.submitters
+    stop = threading.Event()
+
+    def submitter(i):
+        while not stop.is_set():
+            group.submit(None, job)
+            submitted[i] += 1
+            if not submitted[i] % 64:
+                # give the loops a chance when there is a GIL
+                time.sleep(0)
+
+    group.start()
+    for i in range(threads):
+        group.submit(i, setup)
+    for i in range(threads):
+        ready.acquire()
+    workers = [threading.Thread(target=submitter, args=(i,))
+               for i in range(args.submitters)]
+    start = clock()
+    for worker in workers:
+        worker.start()
+    time.sleep(args.duration)
+    stop.set()
+    for worker in workers:
+        worker.join()
+    for i in range(threads):
+        group.submit(i, teardown)
+    for i in range(threads):
+        ready.acquire()
+    group.stop()
+    elapsed = clock() - start
+    if len(done) != sum(submitted):
+        sys.exit("lost submissions: {0} run, {1} submitted".format(
+                 len(done), sum(submitted)))
+    events = sum(pingpong.events for pingpong in pingpongs)
+    return events / elapsed, len(done) / elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--threads", type=int, default=4)
+    parser.add_argument("--pairs", type=int, default=16)
+    parser.add_argument("--submitters", type=int, default=2)
+    parser.add_argument("--duration", type=float, default=3.0)
+    args = parser.parse_args()
+
+    gil = getattr(sys, "_is_gil_enabled", lambda: True)()
+    print("GIL {0}".format("enabled" if gil else "disabled"))
+    print("{0:>8} {1:>12} {2:>12}".format("threads", "events/sec",
+                                           "submits/sec"))
+    for threads in range(1, args.threads + 1):
+        events, submits = run(args, threads)
+        print("{0:>8} {1:>12.0f} {2:>12.0f}".format(threads, events, submits))
+
+
+if __name__ == "__main__":
+    main()
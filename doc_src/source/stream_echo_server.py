@@ -0,0 +1,100 @@
+import socket
+import signal
+import weakref
+import errno
+import logging
+import pyev
+
+logging.basicConfig(level=logging.DEBUG)
+
+STOPSIGNALS = (signal.SIGINT, signal.SIGTERM)
+NONBLOCKING = (errno.EAGAIN, errno.EWOULDBLOCK)
+
+
+class Connection(object):
+
+    def __init__(self, sock, address, loop):
+        self.sock = sock
+        self.address = address
+        self.sock.setblocking(0)
+        self.watcher = pyev.Stream(self.sock, loop, self.stream_cb)
+        self.watcher.start()
+        logging.debug("{0}: ready".format(self))
+
+    def stream_cb(self, watcher, data):
+        if data:
+            # the Stream takes care of partial writes and EV_WRITE
+            watcher.write(data)
+        elif data is None:
+            logging.error("{0}: {1} --> closing".format(
+                self, errno.errorcode.get(watcher.error, watcher.error)))
+            self.close()
+        else:
+            logging.debug("{0}: connection closed by peer".format(self))
+            self.close()
+
+    def close(self):
+        self.sock.close()
+        self.watcher.stop()
+        self.watcher = None
+        logging.debug("{0}: closed".format(self))
+
+
+class Server(object):
+
+    def __init__(self, address):
+        self.sock = socket.socket()
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind(address)
+        self.sock.setblocking(0)
+        self.address = self.sock.getsockname()
+        self.loop = pyev.default_loop()
+        self.watchers = [pyev.Signal(sig, self.loop, self.signal_cb)
+                         for sig in STOPSIGNALS]
+        self.watchers.append(pyev.Io(self.sock, pyev.EV_READ, self.loop,
+                                     self.io_cb))
+        self.conns = weakref.WeakValueDictionary()
+
+    def handle_error(self, msg, level=logging.ERROR, exc_info=True):
+        logging.log(level, "{0}: {1} --> stopping".format(self, msg),
+                    exc_info=exc_info)
+        self.stop()
+
+    def signal_cb(self, watcher, revents):
+        self.stop()
+
+    def io_cb(self, watcher, revents):
+        try:
+            while True:
+                try:
+                    sock, address = self.sock.accept()
+                except socket.error as err:
+                    if err.args[0] in NONBLOCKING:
+                        break
+                    else:
+                        raise
+                else:
+                    self.conns[address] = Connection(sock, address, self.loop)
+        except Exception:
+            self.handle_error("error accepting a connection")
+
+    def start(self):
+        self.sock.listen(socket.SOMAXCONN)
+        for watcher in self.watchers:
+            watcher.start()
+        logging.debug("{0}: started on {0.address}".format(self))
+        self.loop.start()
+
+    def stop(self):
+        self.loop.stop(pyev.EVBREAK_ALL)
+        self.sock.close()
+        while self.watchers:
+            self.watchers.pop().stop()
+        for conn in self.conns.values():
+            conn.close()
+        logging.debug("{0}: stopped".format(self))
+
+
+if __name__ == "__main__":
+    server = Server(("127.0.0.1", 9876))
+    server.start()
@@ -0,0 +1,381 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_ACCEPTOR_BATCH 64
+
+
+/* accept a non-blocking, close-on-exec connection */
+int
+Acceptor_Accept(int fd, struct sockaddr *addr, socklen_t *addrlen)
+{
+#ifdef SOCK_NONBLOCK
+    return accept4(fd, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    int result = accept(fd, addr, addrlen);
+    if (result >= 0 &&
+        (fcntl(result, F_SETFL, fcntl(result, F_GETFL) | O_NONBLOCK) ||
+         fcntl(result, F_SETFD, FD_CLOEXEC))) {
+        close(result);
+        return -1;
+    }
+    return result;
+#endif
+}
+
+
+/* build the (fd, address) or (stream, address) tuple for a connection */
+PyObject *
+Acceptor_Connection(Acceptor *self, int fd,
+                    struct sockaddr *addr, socklen_t addrlen)
+{
+    PyObject *pyfd, *pyaddr, *stream;
+
+    pyfd = PyInt_FromLong(fd);
+    if (!pyfd) {
+        return NULL;
+    }
+    if (self->stream_callback != Py_None) {
+        stream = PyObject_CallFunctionObjArgs((PyObject *)&StreamType, pyfd,
+                                              ((Watcher *)self)->loop,
+                                              self->stream_callback, NULL);
+        Py_DECREF(pyfd);
+        if (!stream) {
+            return NULL;
+        }
+        Watcher_Start((Watcher *)stream);
+        pyfd = stream;
+    }
+    pyaddr = Sockaddr_AsPyObject(addr, addrlen);
+    if (!pyaddr) {
+        Py_DECREF(pyfd);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", pyfd, pyaddr);
+}
+
+
+/* close the connections accepted so far, when the batch cannot be delivered */
+void
+Acceptor_Close(PyObject *connections)
+{
+    PyObject *pyfd;
+    Py_ssize_t i;
+
+    for (i = 0; i < PyList_GET_SIZE(connections); i++) {
+        pyfd = PyTuple_GET_ITEM(PyList_GET_ITEM(connections, i), 0);
+        if (PyObject_TypeCheck(pyfd, &StreamType)) {
+            Watcher_Stop((Watcher *)pyfd);
+            close(((ev_io *)((Watcher *)pyfd)->watcher)->fd);
+        }
+        else {
+            close(PyInt_AsLong(pyfd));
+        }
+    }
+}
+
+
+/* call the Python callback with a list of connections (or None) */
+void
+Acceptor_Invoke(Acceptor *self, struct ev_loop *loop, PyObject *connections)
+{
+    PyObject *pyresult =
+        Callback_Invoke(((Watcher *)self)->callback,
+                        (PyObject *)self, connections);
+    if (!pyresult) {
+        Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+}
+
+
+/* acceptor io callback */
+static void
+Acceptor_Callback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    Acceptor *self = io->data;
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    PyObject *connections, *connection;
+    int fd, error = 0, i = 0;
+
+    if (revents & EV_ERROR) {
+        Watcher_Callback(loop, (ev_watcher *)io, revents);
+        return;
+    }
+    connections = PyList_New(0);
+    if (!connections) {
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    Py_INCREF(self);
+    while (i < self->batch) {
+        addrlen = sizeof(addr);
+        fd = Acceptor_Accept(io->fd, (struct sockaddr *)&addr, &addrlen);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                /* EMFILE, ENFILE, ENOBUFS... */
+                error = self->error = errno;
+            }
+            break;
+        }
+        i++;
+        connection = Acceptor_Connection(self, fd, (struct sockaddr *)&addr,
+                                         addrlen);
+        if (!connection || PyList_Append(connections, connection)) {
+            Py_XDECREF(connection);
+            close(fd);
+            Acceptor_Close(connections);
+            PYEV_LOOP_EXIT(loop);
+            goto finish;
+        }
+        Py_DECREF(connection);
+    }
+    if (PyList_GET_SIZE(connections)) {
+        Acceptor_Invoke(self, loop, connections);
+    }
+    if (error) {
+        /* the listening fd stays readable, do not spin on it */
+        Watcher_Stop((Watcher *)self);
+        Acceptor_Invoke(self, loop, Py_None);
+    }
+
+finish:
+    Py_DECREF(connections);
+    Py_DECREF(self);
+}
+
+
+/* set the Acceptor batch size */
+int
+Acceptor_SetBatch(Acceptor *self, int batch)
+{
+    if (batch <= 0) {
+        PyErr_SetString(PyExc_ValueError, "'batch' must be positive");
+        return -1;
+    }
+    self->batch = batch;
+    return 0;
+}
+
+
+/* set the Acceptor stream callback */
+int
+Acceptor_SetStreamCallback(Acceptor *self, PyObject *stream_callback)
+{
+    PYEV_CHECK_CALLABLE_OR_NONE(stream_callback);
+    PyObject *tmp = self->stream_callback;
+    Py_INCREF(stream_callback);
+    self->stream_callback = stream_callback;
+    Py_XDECREF(tmp);
+    return 0;
+}
+
+
+/*******************************************************************************
+* AcceptorType
+*******************************************************************************/
+
+/* AcceptorType.tp_doc */
+PyDoc_STRVAR(Acceptor_tp_doc,
+"Acceptor(fd, loop, callback[, data=None, priority=0, batch=64,\n\
+          stream_callback=None])");
+
+
+/* AcceptorType.tp_traverse */
+static int
+Acceptor_tp_traverse(Acceptor *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->stream_callback);
+    return Watcher_tp_traverse((Watcher *)self, visit, arg);
+}
+
+
+/* AcceptorType.tp_clear */
+static int
+Acceptor_tp_clear(Acceptor *self)
+{
+    Py_CLEAR(self->stream_callback);
+    return Watcher_tp_clear((Watcher *)self);
+}
+
+
+/* AcceptorType.tp_dealloc */
+static void
+Acceptor_tp_dealloc(Acceptor *self)
+{
+    Py_CLEAR(self->stream_callback);
+    IoType.tp_dealloc((PyObject *)self);
+}
+
+
+/* Acceptor.set(fd) */
+PyDoc_STRVAR(Acceptor_set_doc,
+"set(fd)");
+
+static PyObject *
+Acceptor_set(Acceptor *self, PyObject *args)
+{
+    PyObject *fd;
+
+    PYEV_WATCHER_SET((Watcher *)self);
+    if (!PyArg_ParseTuple(args, "O:set", &fd)) {
+        return NULL;
+    }
+    if (Io_Set((Watcher *)self, fd, EV_READ)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* AcceptorType.tp_methods */
+static PyMethodDef Acceptor_tp_methods[] = {
+    {"set", (PyCFunction)Acceptor_set,
+     METH_VARARGS, Acceptor_set_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* AcceptorType.tp_members */
+static PyMemberDef Acceptor_tp_members[] = {
+    {"error", T_INT, offsetof(Acceptor, error), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* Acceptor.batch */
+static PyObject *
+Acceptor_batch_get(Acceptor *self, void *closure)
+{
+    return PyInt_FromLong(self->batch);
+}
+
+static int
+Acceptor_batch_set(Acceptor *self, PyObject *value, void *closure)
+{
+    PYEV_PROTECTED_ATTRIBUTE(value);
+    long batch = PyInt_AsLong(value);
+    PYEV_CHECK_INT_ATTRIBUTE(batch);
+    return Acceptor_SetBatch(self, batch);
+}
+
+
+/* Acceptor.stream_callback */
+static PyObject *
+Acceptor_stream_callback_get(Acceptor *self, void *closure)
+{
+    Py_INCREF(self->stream_callback);
+    return self->stream_callback;
+}
+
+static int
+Acceptor_stream_callback_set(Acceptor *self, PyObject *value, void *closure)
+{
+    PYEV_PROTECTED_ATTRIBUTE(value);
+    return Acceptor_SetStreamCallback(self, value);
+}
+
+
+/* AcceptorType.tp_getsets */
+static PyGetSetDef Acceptor_tp_getsets[] = {
+    {"batch", (getter)Acceptor_batch_get,
+     (setter)Acceptor_batch_set, NULL, NULL},
+    {"stream_callback", (getter)Acceptor_stream_callback_get,
+     (setter)Acceptor_stream_callback_set, NULL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* AcceptorType.tp_init */
+static int
+Acceptor_tp_init(Acceptor *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *fd;
+    Loop *loop;
+    PyObject *callback, *data = NULL;
+    int priority = 0;
+    int batch = PYEV_ACCEPTOR_BATCH;
+    PyObject *stream_callback = Py_None;
+
+    static char *kwlist[] = {"fd",
+                             "loop", "callback", "data", "priority",
+                             "batch", "stream_callback", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO!O|OiiO:__init__", kwlist,
+            &fd,
+            &LoopType, &loop, &callback, &data, &priority,
+            &batch, &stream_callback)) {
+        return -1;
+    }
+    if (Watcher_Init((Watcher *)self, loop, callback, data, priority) ||
+        Acceptor_SetBatch(self, batch) ||
+        Acceptor_SetStreamCallback(self, stream_callback)) {
+        return -1;
+    }
+    return Io_Set((Watcher *)self, fd, EV_READ);
+}
+
+
+/* AcceptorType.tp_new */
+static PyObject *
+Acceptor_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Acceptor *self = (Acceptor *)IoType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    ev_set_cb((ev_io *)((Watcher *)self)->watcher, Acceptor_Callback);
+    Py_INCREF(Py_None);
+    self->stream_callback = Py_None;
+    self->batch = PYEV_ACCEPTOR_BATCH;
+    return (PyObject *)self;
+}
+
+
+/* AcceptorType */
+static PyTypeObject AcceptorType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.Acceptor",                          /*tp_name*/
+    PYEV_WATCHER_SIZE(Acceptor, ev_io),       /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)Acceptor_tp_dealloc,          /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /*tp_flags*/
+    Acceptor_tp_doc,                          /*tp_doc*/
+    (traverseproc)Acceptor_tp_traverse,       /*tp_traverse*/
+    (inquiry)Acceptor_tp_clear,               /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    Acceptor_tp_methods,                      /*tp_methods*/
+    Acceptor_tp_members,                      /*tp_members*/
+    Acceptor_tp_getsets,                      /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    (initproc)Acceptor_tp_init,               /*tp_init*/
+    0,                                        /*tp_alloc*/
+    Acceptor_tp_new,                          /*tp_new*/
+};
@@ -1,3 +1,97 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+/* push the chain first..last, producers never block each other or the loop */
+void
+Async_Push(Async *self, AsyncNode *first, AsyncNode *last)
+{
+    AsyncNode *head = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+
+    do {
+        last->next = head;
+    } while (!__atomic_compare_exchange_n(&self->head, &head, first, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+
+/* take everything that has been pushed so far, oldest first */
+AsyncNode *
+Async_Pop(Async *self)
+{
+    AsyncNode *node, *next, *result = NULL;
+
+    node = __atomic_exchange_n(&self->head, NULL, __ATOMIC_ACQUIRE);
+    /* the stack is newest first */
+    while (node) {
+        next = node->next;
+        node->next = result;
+        result = node;
+        node = next;
+    }
+    return result;
+}
+
+
+/* free a chain, and drop its objects */
+void
+Async_Free(AsyncNode *node)
+{
+    AsyncNode *next;
+
+    while (node) {
+        next = node->next;
+        Py_DECREF(node->obj);
+        PyMem_Free(node);
+        node = next;
+    }
+}
+
+
+/* async callback, queued objects are handed to the callback as a list */
+static void
+Async_Callback(struct ev_loop *loop, ev_async *async, int revents)
+{
+    Async *self = async->data;
+    AsyncNode *first, *node, *next;
+    PyObject *items, *pyresult;
+    Py_ssize_t count = 0;
+
+    if ((revents & EV_ERROR) ||
+        !__atomic_load_n(&self->head, __ATOMIC_RELAXED)) {
+        Watcher_Callback(loop, (ev_watcher *)async, revents);
+        return;
+    }
+    first = Async_Pop(self);
+    for (node = first; node; node = node->next) {
+        count++;
+    }
+    items = PyList_New(count);
+    if (!items) {
+        Async_Free(first);
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    for (count = 0, node = first; node; count++, node = next) {
+        next = node->next;
+        /* steals the reference */
+        PyList_SET_ITEM(items, count, node->obj);
+        PyMem_Free(node);
+    }
+    Py_INCREF(self);
+    pyresult = Callback_Invoke(((Watcher *)self)->callback,
+                               (PyObject *)self, items);
+    if (!pyresult) {
+        Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+    Py_DECREF(items);
+    Py_DECREF(self);
+}
+
+
 /*******************************************************************************
 * AsyncType
 *******************************************************************************/
@@ -7,14 +101,106 @@ PyDoc_STRVAR(Async_tp_doc,
 "Async(loop, callback[, data=None, priority=0])");
 
 
-/* Async.send() */
+/* AsyncType.tp_traverse */
+static int
+Async_tp_traverse(Async *self, visitproc visit, void *arg)
+{
+    AsyncNode *node;
+
+    /* producers hold the GIL (or the world is stopped) while we run */
+    for (node = self->head; node; node = node->next) {
+        Py_VISIT(node->obj);
+    }
+    return Watcher_tp_traverse((Watcher *)self, visit, arg);
+}
+
+
+/* AsyncType.tp_clear */
+static int
+Async_tp_clear(Async *self)
+{
+    Async_Free(Async_Pop(self));
+    return Watcher_tp_clear((Watcher *)self);
+}
+
+
+/* AsyncType.tp_dealloc */
+static void
+Async_tp_dealloc(Async *self)
+{
+    Async_Free(Async_Pop(self));
+    WatcherType.tp_dealloc((PyObject *)self);
+}
+
+
+/* Async.send([obj]) */
 PyDoc_STRVAR(Async_send_doc,
-"send()");
+"send([obj])");
 
 static PyObject *
-Async_send(Watcher *self)
+Async_send(Async *self, PyObject *args)
 {
-    ev_async_send(self->loop->loop, (ev_async *)self->watcher);
+    PyObject *obj = NULL;
+    AsyncNode *node;
+
+    if (!PyArg_ParseTuple(args, "|O:send", &obj)) {
+        return NULL;
+    }
+    if (obj) {
+        node = PyMem_Malloc(sizeof(AsyncNode));
+        if (!node) {
+            return PyErr_NoMemory();
+        }
+        Py_INCREF(obj);
+        node->obj = obj;
+        Async_Push(self, node, node);
+    }
+    ev_async_send(((Watcher *)self)->loop->loop,
+                  (ev_async *)((Watcher *)self)->watcher);
+    Py_RETURN_NONE;
+}
+
+
+/* Async.send_many(objs) */
+PyDoc_STRVAR(Async_send_many_doc,
+"send_many(objs)");
+
+static PyObject *
+Async_send_many(Async *self, PyObject *objs)
+{
+    PyObject *iterator, *obj;
+    AsyncNode *first = NULL, *last = NULL, *node;
+
+    iterator = PyObject_GetIter(objs);
+    if (!iterator) {
+        return NULL;
+    }
+    while ((obj = PyIter_Next(iterator))) {
+        node = PyMem_Malloc(sizeof(AsyncNode));
+        if (!node) {
+            Py_DECREF(obj);
+            PyErr_NoMemory();
+            break;
+        }
+        /* steals the reference */
+        node->obj = obj;
+        /* the stack is newest first */
+        node->next = first;
+        first = node;
+        if (!last) {
+            last = node;
+        }
+    }
+    Py_DECREF(iterator);
+    if (PyErr_Occurred()) {
+        Async_Free(first);
+        return NULL;
+    }
+    if (first) {
+        Async_Push(self, first, last);
+        ev_async_send(((Watcher *)self)->loop->loop,
+                      (ev_async *)((Watcher *)self)->watcher);
+    }
     Py_RETURN_NONE;
 }
 
@@ -22,7 +208,9 @@ Async_send(Watcher *self)
 /* AsyncType.tp_methods */
 static PyMethodDef Async_tp_methods[] = {
     {"send", (PyCFunction)Async_send,
-     METH_NOARGS, Async_send_doc},
+     METH_VARARGS, Async_send_doc},
+    {"send_many", (PyCFunction)Async_send_many,
+     METH_O, Async_send_many_doc},
     {NULL}  /* Sentinel */
 };
 
@@ -43,11 +231,20 @@ static PyGetSetDef Async_tp_getsets[] = {
 };
 
 
+/* AsyncType operations */
+PYEV_WATCHER_OPS(ev_async, EV_ASYNC, 0);
+
+
 /* AsyncType.tp_new */
 static PyObject *
 Async_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_ASYNC, sizeof(ev_async));
+    Watcher *self = Watcher_New(type, &ev_async_ops);
+    if (!self) {
+        return NULL;
+    }
+    ev_set_cb((ev_async *)self->watcher, Async_Callback);
+    return (PyObject *)self;
 }
 
 
@@ -55,9 +252,9 @@ Async_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject AsyncType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Async",                             /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Async, ev_async),       /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
-    0,                                        /*tp_dealloc*/
+    (destructor)Async_tp_dealloc,             /*tp_dealloc*/
     0,                                        /*tp_print*/
     0,                                        /*tp_getattr*/
     0,                                        /*tp_setattr*/
@@ -72,10 +269,10 @@ static PyTypeObject AsyncType = {
     0,                                        /*tp_getattro*/
     0,                                        /*tp_setattro*/
     0,                                        /*tp_as_buffer*/
-    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /*tp_flags*/
     Async_tp_doc,                             /*tp_doc*/
-    0,                                        /*tp_traverse*/
-    0,                                        /*tp_clear*/
+    (traverseproc)Async_tp_traverse,          /*tp_traverse*/
+    (inquiry)Async_tp_clear,                  /*tp_clear*/
     0,                                        /*tp_richcompare*/
     0,                                        /*tp_weaklistoffset*/
     0,                                        /*tp_iter*/
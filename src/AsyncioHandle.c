@@ -0,0 +1,480 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+/* create a handle for callback(*args), run in context (a copy of the current
+   context if NULL or None) */
+AsyncioHandle *
+AsyncioHandle_New(PyTypeObject *type, AsyncioCore *core, PyObject *callback,
+                  PyObject *args, PyObject *context)
+{
+    AsyncioHandle *self = (AsyncioHandle *)type->tp_alloc(type, 0);
+    if (!self) {
+        return NULL;
+    }
+    if (!context || context == Py_None) {
+        self->context = PyContext_CopyCurrent();
+        if (!self->context) {
+            Py_DECREF(self);
+            return NULL;
+        }
+    }
+    else {
+        Py_INCREF(context);
+        self->context = context;
+    }
+    Py_INCREF(core);
+    self->core = core;
+    Py_INCREF(callback);
+    self->callback = callback;
+    Py_INCREF(args);
+    self->args = args;
+    return self;
+}
+
+
+/* stop a timer handle, it loses the reference its timer held */
+void
+AsyncioTimerHandle_Stop(AsyncioTimerHandle *self)
+{
+    AsyncioCore *core = ((AsyncioHandle *)self)->core;
+    ev_timer *timer = &self->timer;
+
+    if (ev_is_active(timer)) {
+        ev_timer_stop(core->loop->loop, timer);
+        if (self->prev) {
+            self->prev->next = self->next;
+        }
+        else {
+            core->timers = self->next;
+        }
+        if (self->next) {
+            self->next->prev = self->prev;
+        }
+        self->prev = self->next = NULL;
+        Py_DECREF(self);
+    }
+}
+
+
+void
+AsyncioHandle_Cancel(AsyncioHandle *self)
+{
+    if (self->cancelled) {
+        return;
+    }
+    self->cancelled = 1;
+    if (PyObject_TypeCheck(self, &AsyncioTimerHandleType)) {
+        AsyncioTimerHandle_Stop((AsyncioTimerHandle *)self);
+    }
+}
+
+
+/* loop.call_exception_handler(context), steals the reference to context
+   (NULL if building it failed) */
+void
+Asyncio_CallExceptionHandler(PyObject *loop, PyObject *context)
+{
+    PyObject *result;
+
+    if (context) {
+        result = PyObject_CallMethod(loop, "call_exception_handler", "O",
+                                     context);
+        Py_DECREF(context);
+        Py_XDECREF(result);
+    }
+    if (PyErr_Occurred()) {
+        PyErr_WriteUnraisable(loop);
+    }
+}
+
+
+/* the current exception, normalized and with its traceback attached */
+PyObject *
+Asyncio_FetchError(void)
+{
+    PyObject *type, *value, *traceback;
+
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+    if (value && traceback) {
+        PyException_SetTraceback(value, traceback);
+    }
+    Py_XDECREF(type);
+    Py_XDECREF(traceback);
+    return value;
+}
+
+
+/* report an error raised by a handle to the loop's exception handler */
+void
+AsyncioHandle_Report(AsyncioHandle *self)
+{
+    PyObject *value = Asyncio_FetchError();
+
+    Asyncio_CallExceptionHandler(self->core->owner,
+        Py_BuildValue("{s:N,s:O,s:O}",
+                      "message",
+                      PyUnicode_FromFormat("Exception in callback %R", self),
+                      "exception", value ? value : Py_None,
+                      "handle", self));
+    Py_XDECREF(value);
+}
+
+
+/* run the callback in the handle's context, errors are reported to the loop
+   except SystemExit and KeyboardInterrupt, then -1 is returned */
+int
+AsyncioHandle_Run(AsyncioHandle *self)
+{
+    PyObject *callback = self->callback, *args = self->args;
+    PyObject *context = self->context, *result;
+
+    /* the callback could cancel us */
+    Py_INCREF(callback);
+    Py_INCREF(args);
+    Py_INCREF(context);
+    if (PyContext_Enter(context)) {
+        result = NULL;
+    }
+    else {
+        result = PyObject_Call(callback, args, NULL);
+        if (PyContext_Exit(context)) {
+            Py_CLEAR(result);
+        }
+    }
+    Py_DECREF(context);
+    Py_DECREF(args);
+    Py_DECREF(callback);
+    if (!result) {
+        if (PyErr_ExceptionMatches(PyExc_SystemExit) ||
+            PyErr_ExceptionMatches(PyExc_KeyboardInterrupt)) {
+            return -1;
+        }
+        AsyncioHandle_Report(self);
+        return 0;
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+/*******************************************************************************
+* AsyncioHandleType
+*******************************************************************************/
+
+/* AsyncioHandleType.tp_doc */
+PyDoc_STRVAR(AsyncioHandle_tp_doc,
+"Handle");
+
+
+/* AsyncioHandleType.tp_traverse */
+static int
+AsyncioHandle_tp_traverse(AsyncioHandle *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->core);
+    Py_VISIT(self->callback);
+    Py_VISIT(self->args);
+    Py_VISIT(self->context);
+    return 0;
+}
+
+
+/* AsyncioHandleType.tp_clear */
+static int
+AsyncioHandle_tp_clear(AsyncioHandle *self)
+{
+    Py_CLEAR(self->callback);
+    Py_CLEAR(self->args);
+    Py_CLEAR(self->context);
+    Py_CLEAR(self->core);
+    return 0;
+}
+
+
+/* AsyncioHandleType.tp_dealloc */
+static void
+AsyncioHandle_tp_dealloc(AsyncioHandle *self)
+{
+    PyObject_GC_UnTrack(self);
+    AsyncioHandle_tp_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+/* AsyncioHandleType.tp_repr */
+static PyObject *
+AsyncioHandle_tp_repr(AsyncioHandle *self)
+{
+    if (self->cancelled || !self->callback) {
+        return PyUnicode_FromFormat("<%s cancelled>", Py_TYPE(self)->tp_name);
+    }
+    return PyUnicode_FromFormat("<%s %R%R>", Py_TYPE(self)->tp_name,
+                                self->callback, self->args);
+}
+
+
+/* Handle.cancel() */
+PyDoc_STRVAR(AsyncioHandle_cancel_doc,
+"cancel()");
+
+static PyObject *
+AsyncioHandle_cancel(AsyncioHandle *self)
+{
+    AsyncioHandle_Cancel(self);
+    Py_RETURN_NONE;
+}
+
+
+/* Handle.cancelled() -> bool */
+PyDoc_STRVAR(AsyncioHandle_cancelled_doc,
+"cancelled() -> bool");
+
+static PyObject *
+AsyncioHandle_cancelled(AsyncioHandle *self)
+{
+    return PyBool_FromLong(self->cancelled);
+}
+
+
+/* Handle.get_context() -> contextvars.Context */
+PyDoc_STRVAR(AsyncioHandle_get_context_doc,
+"get_context() -> contextvars.Context");
+
+static PyObject *
+AsyncioHandle_get_context(AsyncioHandle *self)
+{
+    if (!self->context) {
+        Py_RETURN_NONE;
+    }
+    Py_INCREF(self->context);
+    return self->context;
+}
+
+
+/* Handle._run() */
+PyDoc_STRVAR(AsyncioHandle__run_doc,
+"_run()");
+
+static PyObject *
+AsyncioHandle__run(AsyncioHandle *self)
+{
+    if (!self->cancelled && AsyncioHandle_Run(self)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* AsyncioHandleType.tp_methods */
+static PyMethodDef AsyncioHandle_tp_methods[] = {
+    {"cancel", (PyCFunction)AsyncioHandle_cancel,
+     METH_NOARGS, AsyncioHandle_cancel_doc},
+    {"cancelled", (PyCFunction)AsyncioHandle_cancelled,
+     METH_NOARGS, AsyncioHandle_cancelled_doc},
+    {"get_context", (PyCFunction)AsyncioHandle_get_context,
+     METH_NOARGS, AsyncioHandle_get_context_doc},
+    {"_run", (PyCFunction)AsyncioHandle__run,
+     METH_NOARGS, AsyncioHandle__run_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* Handle._source_traceback, asyncio's debug mode isn't tracked */
+static PyObject *
+AsyncioHandle__source_traceback_get(AsyncioHandle *self, void *closure)
+{
+    Py_RETURN_NONE;
+}
+
+
+/* AsyncioHandleType.tp_getsets */
+static PyGetSetDef AsyncioHandle_tp_getsets[] = {
+    {"_source_traceback", (getter)AsyncioHandle__source_traceback_get,
+     Readonly_attribute_set, NULL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* AsyncioHandleType */
+static PyTypeObject AsyncioHandleType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.asyncio.Handle",                    /*tp_name*/
+    sizeof(AsyncioHandle),                    /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)AsyncioHandle_tp_dealloc,     /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    (reprfunc)AsyncioHandle_tp_repr,          /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /*tp_flags*/
+    AsyncioHandle_tp_doc,                     /*tp_doc*/
+    (traverseproc)AsyncioHandle_tp_traverse,  /*tp_traverse*/
+    (inquiry)AsyncioHandle_tp_clear,          /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    AsyncioHandle_tp_methods,                 /*tp_methods*/
+    0,                                        /*tp_members*/
+    AsyncioHandle_tp_getsets,                 /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    0,                                        /*tp_init*/
+    0,                                        /*tp_alloc*/
+    0,                                        /*tp_new*/
+};
+
+
+/*******************************************************************************
+* AsyncioTimerHandleType
+*******************************************************************************/
+
+/* timer callback, the handle is ready */
+static void
+AsyncioTimerHandle_Callback(struct ev_loop *loop, ev_timer *timer, int revents)
+{
+    AsyncioTimerHandle *self = timer->data;
+    AsyncioCore *core = ((AsyncioHandle *)self)->core;
+
+    /* libev stopped it, the reference of the timer goes to the ready queue */
+    if (self->prev) {
+        self->prev->next = self->next;
+    }
+    else {
+        core->timers = self->next;
+    }
+    if (self->next) {
+        self->next->prev = self->prev;
+    }
+    self->prev = self->next = NULL;
+    AsyncioCore_Push(core, (AsyncioHandle *)self);
+    Py_DECREF(self);
+}
+
+
+/* start the timer of a new timer handle, at loop time 'when' */
+void
+AsyncioTimerHandle_Start(AsyncioTimerHandle *self, double when)
+{
+    AsyncioCore *core = ((AsyncioHandle *)self)->core;
+    ev_timer *timer = &self->timer;
+    double after;
+
+    self->when = when;
+    /* timers are relative to the loop time, which gets stale while
+       callbacks run */
+    ev_now_update(core->loop->loop);
+    after = when - Asyncio_Time();
+    ev_timer_init(timer, AsyncioTimerHandle_Callback, after > 0 ? after : 0, 0);
+    timer->data = self;
+    ev_timer_start(core->loop->loop, timer);
+    /* the timer holds a reference */
+    Py_INCREF(self);
+    self->next = core->timers;
+    if (core->timers) {
+        core->timers->prev = self;
+    }
+    core->timers = self;
+}
+
+
+/* AsyncioTimerHandleType.tp_doc */
+PyDoc_STRVAR(AsyncioTimerHandle_tp_doc,
+"TimerHandle");
+
+
+/* AsyncioTimerHandleType.tp_repr */
+static PyObject *
+AsyncioTimerHandle_tp_repr(AsyncioTimerHandle *self)
+{
+    PyObject *when, *result;
+
+    if (((AsyncioHandle *)self)->cancelled) {
+        return AsyncioHandle_tp_repr((AsyncioHandle *)self);
+    }
+    when = PyFloat_FromDouble(self->when);
+    if (!when) {
+        return NULL;
+    }
+    result = PyUnicode_FromFormat("<%s when=%R %R%R>", Py_TYPE(self)->tp_name,
+                                  when, ((AsyncioHandle *)self)->callback,
+                                  ((AsyncioHandle *)self)->args);
+    Py_DECREF(when);
+    return result;
+}
+
+
+/* TimerHandle.when() -> float */
+PyDoc_STRVAR(AsyncioTimerHandle_when_doc,
+"when() -> float");
+
+static PyObject *
+AsyncioTimerHandle_when(AsyncioTimerHandle *self)
+{
+    return PyFloat_FromDouble(self->when);
+}
+
+
+/* AsyncioTimerHandleType.tp_methods */
+static PyMethodDef AsyncioTimerHandle_tp_methods[] = {
+    {"when", (PyCFunction)AsyncioTimerHandle_when,
+     METH_NOARGS, AsyncioTimerHandle_when_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* AsyncioTimerHandleType */
+static PyTypeObject AsyncioTimerHandleType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.asyncio.TimerHandle",               /*tp_name*/
+    sizeof(AsyncioTimerHandle),               /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)AsyncioHandle_tp_dealloc,     /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    (reprfunc)AsyncioTimerHandle_tp_repr,     /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /*tp_flags*/
+    AsyncioTimerHandle_tp_doc,                /*tp_doc*/
+    (traverseproc)AsyncioHandle_tp_traverse,  /*tp_traverse*/
+    (inquiry)AsyncioHandle_tp_clear,          /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    AsyncioTimerHandle_tp_methods,            /*tp_methods*/
+    0,                                        /*tp_members*/
+    0,                                        /*tp_getsets*/
+    &AsyncioHandleType,                       /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    0,                                        /*tp_init*/
+    0,                                        /*tp_alloc*/
+    0,                                        /*tp_new*/
+};
@@ -0,0 +1,1091 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+/* the instance attribute holding the AsyncioCore of an EventLoop */
+static PyObject *Asyncio_CoreName = NULL;
+
+/* "pyev.asyncio" */
+static PyObject *Asyncio_ModuleName = NULL;
+
+
+/* asyncio's clock (time.monotonic()) */
+double
+Asyncio_Time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/* args[0:count] as a tuple */
+PyObject *
+Asyncio_Tuple(PyObject *const *args, Py_ssize_t count)
+{
+    PyObject *result = PyTuple_New(count);
+    Py_ssize_t i;
+
+    if (!result) {
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        Py_INCREF(args[i]);
+        PyTuple_SET_ITEM(result, i, args[i]);
+    }
+    return result;
+}
+
+
+/* the only keyword argument accepted is 'context' */
+int
+Asyncio_ParseContext(const char *name, PyObject *const *args, Py_ssize_t nargs,
+                     PyObject *kwnames, PyObject **context)
+{
+    *context = NULL;
+    if (kwnames && PyTuple_GET_SIZE(kwnames)) {
+        if (PyTuple_GET_SIZE(kwnames) != 1 ||
+            PyUnicode_CompareWithASCIIString(PyTuple_GET_ITEM(kwnames, 0),
+                                             "context")) {
+            PyErr_Format(PyExc_TypeError,
+                         "%s() got an unexpected keyword argument", name);
+            return -1;
+        }
+        *context = args[nargs];
+    }
+    return 0;
+}
+
+
+int
+Asyncio_CheckArgs(const char *name, Py_ssize_t nargs, Py_ssize_t min)
+{
+    if (nargs < min) {
+        PyErr_Format(PyExc_TypeError,
+                     "%s() takes at least %zd arguments (%zd given)",
+                     name, min - 1, nargs - 1);
+        return -1;
+    }
+    return 0;
+}
+
+
+/* the AsyncioCore of an EventLoop (new reference) */
+AsyncioCore *
+Asyncio_GetCore(PyObject *loop)
+{
+    PyObject *core = PyObject_GetAttr(loop, Asyncio_CoreName);
+
+    if (core && !PyObject_TypeCheck(core, &AsyncioCoreType)) {
+        Py_DECREF(core);
+        PyErr_SetString(PyExc_TypeError, "not a pyev.asyncio.EventLoop");
+        return NULL;
+    }
+    return (AsyncioCore *)core;
+}
+
+
+/* same as the AsyncioCore of an EventLoop, but closed is an error */
+AsyncioCore *
+Asyncio_GetOpenCore(PyObject *loop)
+{
+    AsyncioCore *core = Asyncio_GetCore(loop);
+
+    if (core && core->closed) {
+        Py_DECREF(core);
+        PyErr_SetString(PyExc_RuntimeError, "Event loop is closed");
+        return NULL;
+    }
+    return core;
+}
+
+
+/*******************************************************************************
+* AsyncioCore
+*******************************************************************************/
+
+/* append a handle to the ready queue (if it isn't queued already) */
+void
+AsyncioCore_Push(AsyncioCore *self, AsyncioHandle *handle)
+{
+    PYEV_BEGIN_LOCK(self);
+    if (!handle->queued) {
+        Py_INCREF(handle);
+        handle->queued = 1;
+        handle->next = NULL;
+        if (self->last) {
+            self->last->next = handle;
+        }
+        else {
+            self->first = handle;
+        }
+        self->last = handle;
+        self->ready++;
+    }
+    PYEV_END_LOCK();
+}
+
+
+/* pop the first ready handle, returns the reference the queue held */
+AsyncioHandle *
+AsyncioCore_Pop(AsyncioCore *self)
+{
+    AsyncioHandle *handle;
+
+    PYEV_BEGIN_LOCK(self);
+    handle = self->first;
+    if (handle) {
+        if (!(self->first = handle->next)) {
+            self->last = NULL;
+        }
+        handle->next = NULL;
+        handle->queued = 0;
+        self->ready--;
+    }
+    PYEV_END_LOCK();
+    return handle;
+}
+
+
+/* io callback, queue the reader and/or the writer */
+static void
+AsyncioCore_IoCallback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    AsyncioIo *entry = (AsyncioIo *)io;
+    AsyncioCore *self = io->data;
+
+    if ((revents & (EV_READ | EV_ERROR)) && entry->reader) {
+        AsyncioCore_Push(self, entry->reader);
+    }
+    if ((revents & (EV_WRITE | EV_ERROR)) && entry->writer) {
+        AsyncioCore_Push(self, entry->writer);
+    }
+}
+
+
+/* set (or remove, when handle is NULL) the reader or the writer of fd, steals
+   the reference to handle and returns the previous one in *previous */
+int
+AsyncioCore_SetHandler(AsyncioCore *self, int fd, int event,
+                       AsyncioHandle *handle, AsyncioHandle **previous)
+{
+    AsyncioIo *entry, **fds;
+    ev_io *io;
+    int nfds, events;
+
+    *previous = NULL;
+    if (fd >= self->nfds) {
+        if (!handle) {
+            return 0;
+        }
+        nfds = self->nfds ? self->nfds * 2 : 64;
+        while (nfds <= fd) {
+            nfds *= 2;
+        }
+        fds = PyMem_Realloc(self->fds, nfds * sizeof(AsyncioIo *));
+        if (!fds) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        memset(fds + self->nfds, 0, (nfds - self->nfds) * sizeof(AsyncioIo *));
+        self->fds = fds;
+        self->nfds = nfds;
+    }
+    entry = self->fds[fd];
+    if (!entry) {
+        if (!handle) {
+            return 0;
+        }
+        entry = PyMem_Malloc(sizeof(AsyncioIo));
+        if (!entry) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        entry->reader = entry->writer = NULL;
+        io = &entry->io;
+        ev_io_init(io, AsyncioCore_IoCallback, fd, 0);
+        io->data = self;
+        self->fds[fd] = entry;
+    }
+    io = &entry->io;
+    if (event == EV_READ) {
+        *previous = entry->reader;
+        entry->reader = handle;
+    }
+    else {
+        *previous = entry->writer;
+        entry->writer = handle;
+    }
+    events = (entry->reader ? EV_READ : 0) | (entry->writer ? EV_WRITE : 0);
+    ev_io_stop(self->loop->loop, io);
+    if (events) {
+        PYEV_IO_MODIFY(io, events);
+        ev_io_start(self->loop->loop, io);
+    }
+    else {
+        PyMem_Free(entry);
+        self->fds[fd] = NULL;
+    }
+    return 0;
+}
+
+
+/* stop everything, pending handles are dropped */
+void
+AsyncioCore_Close(AsyncioCore *self)
+{
+    AsyncioHandle *handle;
+    AsyncioIo *entry;
+    int fd;
+
+    self->closed = 1;
+    for (fd = 0; fd < self->nfds; fd++) {
+        if ((entry = self->fds[fd])) {
+            ev_io_stop(self->loop->loop, &entry->io);
+            self->fds[fd] = NULL;
+            Py_XDECREF(entry->reader);
+            Py_XDECREF(entry->writer);
+            PyMem_Free(entry);
+        }
+    }
+    PyMem_Free(self->fds);
+    self->fds = NULL;
+    self->nfds = 0;
+    while (self->timers) {
+        AsyncioTimerHandle_Stop(self->timers);
+    }
+    while ((handle = AsyncioCore_Pop(self))) {
+        Py_DECREF(handle);
+    }
+}
+
+
+/* AsyncioCoreType.tp_traverse */
+static int
+AsyncioCore_tp_traverse(AsyncioCore *self, visitproc visit, void *arg)
+{
+    AsyncioHandle *handle;
+    AsyncioTimerHandle *timer;
+    int fd;
+
+    Py_VISIT(self->loop);
+    Py_VISIT(self->owner);
+    for (handle = self->first; handle; handle = handle->next) {
+        Py_VISIT(handle);
+    }
+    for (timer = self->timers; timer; timer = timer->next) {
+        Py_VISIT(timer);
+    }
+    for (fd = 0; fd < self->nfds; fd++) {
+        if (self->fds[fd]) {
+            Py_VISIT(self->fds[fd]->reader);
+            Py_VISIT(self->fds[fd]->writer);
+        }
+    }
+    return 0;
+}
+
+
+/* AsyncioCoreType.tp_clear */
+static int
+AsyncioCore_tp_clear(AsyncioCore *self)
+{
+    if (self->loop) {
+        AsyncioCore_Close(self);
+    }
+    Py_CLEAR(self->owner);
+    Py_CLEAR(self->loop);
+    return 0;
+}
+
+
+/* AsyncioCoreType.tp_dealloc */
+static void
+AsyncioCore_tp_dealloc(AsyncioCore *self)
+{
+    PyObject_GC_UnTrack(self);
+    AsyncioCore_tp_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+/* AsyncioCoreType */
+static PyTypeObject AsyncioCoreType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.asyncio.Core",                      /*tp_name*/
+    sizeof(AsyncioCore),                      /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)AsyncioCore_tp_dealloc,       /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                        /*tp_doc*/
+    (traverseproc)AsyncioCore_tp_traverse,    /*tp_traverse*/
+    (inquiry)AsyncioCore_tp_clear,            /*tp_clear*/
+};
+
+
+/* a core for the EventLoop owner, running on a new Loop */
+AsyncioCore *
+AsyncioCore_New(PyObject *owner)
+{
+    AsyncioCore *self =
+        (AsyncioCore *)AsyncioCoreType.tp_alloc(&AsyncioCoreType, 0);
+    if (!self) {
+        return NULL;
+    }
+    self->loop = (Loop *)PyObject_CallFunctionObjArgs((PyObject *)&LoopType,
+                                                      NULL);
+    if (!self->loop) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    Py_INCREF(owner);
+    self->owner = owner;
+    return self;
+}
+
+
+/*******************************************************************************
+* EventLoop methods, installed in a subclass of asyncio.SelectorEventLoop
+* (args[0] is the EventLoop)
+*******************************************************************************/
+
+/* EventLoop.__init__() */
+static PyObject *
+AsyncioLoop___init__(PyObject *unused, PyObject *const *args, Py_ssize_t nargs)
+{
+    PyObject *self = args[0], *selectors, *selector = NULL, *base = NULL;
+    PyObject *result = NULL;
+    AsyncioCore *core;
+
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "__init__() takes no arguments");
+        return NULL;
+    }
+    core = AsyncioCore_New(self);
+    if (!core) {
+        return NULL;
+    }
+    if (PyObject_SetAttr(self, Asyncio_CoreName, (PyObject *)core) ||
+        PyObject_SetAttrString(self, "pyev_loop", (PyObject *)core->loop)) {
+        goto fail;
+    }
+    /* the base class wants a selector, it never gets to use it */
+    selectors = PyImport_ImportModule("selectors");
+    if (!selectors) {
+        goto fail;
+    }
+    selector = PyObject_CallMethod(selectors, "SelectSelector", NULL);
+    Py_DECREF(selectors);
+    if (!selector || !(base = PyObject_GetAttrString(self, "_pyev_base"))) {
+        goto fail;
+    }
+    result = PyObject_CallMethod(base, "__init__", "OO", self, selector);
+
+fail:
+    Py_XDECREF(base);
+    Py_XDECREF(selector);
+    Py_DECREF(core);
+    return result;
+}
+
+
+/* EventLoop.time() -> float */
+static PyObject *
+AsyncioLoop_time(PyObject *unused, PyObject *const *args, Py_ssize_t nargs)
+{
+    return PyFloat_FromDouble(Asyncio_Time());
+}
+
+
+/* queue callback(*args) */
+PyObject *
+AsyncioLoop_CallSoon(PyObject *loop, PyObject *callback, PyObject *args,
+                     PyObject *context)
+{
+    AsyncioCore *core = Asyncio_GetOpenCore(loop);
+    AsyncioHandle *handle;
+
+    if (!core) {
+        return NULL;
+    }
+    handle = AsyncioHandle_New(&AsyncioHandleType, core, callback, args,
+                               context);
+    if (handle) {
+        AsyncioCore_Push(core, handle);
+    }
+    Py_DECREF(core);
+    return (PyObject *)handle;
+}
+
+
+/* EventLoop.call_soon(callback, *args, context=None) -> Handle */
+static PyObject *
+AsyncioLoop_call_soon(PyObject *unused, PyObject *const *args,
+                      Py_ssize_t nargs, PyObject *kwnames)
+{
+    PyObject *context, *pyargs, *result;
+
+    if (Asyncio_CheckArgs("call_soon", nargs, 2) ||
+        Asyncio_ParseContext("call_soon", args, nargs, kwnames, &context)) {
+        return NULL;
+    }
+    if (!(pyargs = Asyncio_Tuple(args + 2, nargs - 2))) {
+        return NULL;
+    }
+    result = AsyncioLoop_CallSoon(args[0], args[1], pyargs, context);
+    Py_DECREF(pyargs);
+    return result;
+}
+
+
+/* EventLoop.call_soon_threadsafe(callback, *args, context=None) -> Handle */
+static PyObject *
+AsyncioLoop_call_soon_threadsafe(PyObject *unused, PyObject *const *args,
+                                 Py_ssize_t nargs, PyObject *kwnames)
+{
+    PyObject *handle, *result;
+
+    if (!(handle = AsyncioLoop_call_soon(unused, args, nargs, kwnames))) {
+        return NULL;
+    }
+    /* wake up the loop through the self-pipe */
+    if (!(result = PyObject_CallMethod(args[0], "_write_to_self", NULL))) {
+        Py_DECREF(handle);
+        return NULL;
+    }
+    Py_DECREF(result);
+    return handle;
+}
+
+
+/* EventLoop._call_soon(callback, args, context) -> Handle */
+static PyObject *
+AsyncioLoop__call_soon(PyObject *unused, PyObject *const *args,
+                       Py_ssize_t nargs)
+{
+    PyObject *pyargs, *result;
+
+    if (nargs != 4) {
+        PyErr_SetString(PyExc_TypeError, "_call_soon() takes 3 arguments");
+        return NULL;
+    }
+    if (!(pyargs = PySequence_Tuple(args[2]))) {
+        return NULL;
+    }
+    result = AsyncioLoop_CallSoon(args[0], args[1], pyargs, args[3]);
+    Py_DECREF(pyargs);
+    return result;
+}
+
+
+/* EventLoop._add_callback(handle), an asyncio.Handle from a signal handler */
+static PyObject *
+AsyncioLoop__add_callback(PyObject *unused, PyObject *const *args,
+                          Py_ssize_t nargs)
+{
+    PyObject *cancelled, *run, *pyargs, *result;
+    int skip;
+
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "_add_callback() takes 1 argument");
+        return NULL;
+    }
+    cancelled = PyObject_GetAttrString(args[1], "_cancelled");
+    if (!cancelled) {
+        return NULL;
+    }
+    skip = PyObject_IsTrue(cancelled);
+    Py_DECREF(cancelled);
+    if (skip) {
+        if (skip < 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+    /* Handle._run() runs it in its own context */
+    if (!(run = PyObject_GetAttrString(args[1], "_run"))) {
+        return NULL;
+    }
+    if (!(pyargs = PyTuple_New(0))) {
+        Py_DECREF(run);
+        return NULL;
+    }
+    result = AsyncioLoop_CallSoon(args[0], run, pyargs, NULL);
+    Py_DECREF(pyargs);
+    Py_DECREF(run);
+    if (!result) {
+        return NULL;
+    }
+    Py_DECREF(result);
+    Py_RETURN_NONE;
+}
+
+
+/* start a TimerHandle for callback(*args) at when */
+PyObject *
+AsyncioLoop_CallAt(PyObject *loop, double when, PyObject *const *args,
+                   Py_ssize_t nargs, PyObject *context)
+{
+    AsyncioCore *core;
+    AsyncioHandle *handle = NULL;
+    PyObject *pyargs;
+
+    if (!(core = Asyncio_GetOpenCore(loop))) {
+        return NULL;
+    }
+    if ((pyargs = Asyncio_Tuple(args + 1, nargs - 1))) {
+        handle = AsyncioHandle_New(&AsyncioTimerHandleType, core, args[0],
+                                   pyargs, context);
+        if (handle) {
+            AsyncioTimerHandle_Start((AsyncioTimerHandle *)handle, when);
+        }
+        Py_DECREF(pyargs);
+    }
+    Py_DECREF(core);
+    return (PyObject *)handle;
+}
+
+
+/* EventLoop.call_later(delay, callback, *args, context=None) -> TimerHandle */
+static PyObject *
+AsyncioLoop_call_later(PyObject *unused, PyObject *const *args,
+                       Py_ssize_t nargs, PyObject *kwnames)
+{
+    PyObject *context;
+    double delay;
+
+    if (Asyncio_CheckArgs("call_later", nargs, 3) ||
+        Asyncio_ParseContext("call_later", args, nargs, kwnames, &context)) {
+        return NULL;
+    }
+    delay = PyFloat_AsDouble(args[1]);
+    if (delay == -1.0 && PyErr_Occurred()) {
+        return NULL;
+    }
+    return AsyncioLoop_CallAt(args[0], Asyncio_Time() + delay, args + 2,
+                              nargs - 2, context);
+}
+
+
+/* EventLoop.call_at(when, callback, *args, context=None) -> TimerHandle */
+static PyObject *
+AsyncioLoop_call_at(PyObject *unused, PyObject *const *args,
+                    Py_ssize_t nargs, PyObject *kwnames)
+{
+    PyObject *context;
+    double when;
+
+    if (Asyncio_CheckArgs("call_at", nargs, 3) ||
+        Asyncio_ParseContext("call_at", args, nargs, kwnames, &context)) {
+        return NULL;
+    }
+    when = PyFloat_AsDouble(args[1]);
+    if (when == -1.0 && PyErr_Occurred()) {
+        return NULL;
+    }
+    return AsyncioLoop_CallAt(args[0], when, args + 2, nargs - 2, context);
+}
+
+
+/* set the reader/writer of a fd */
+static PyObject *
+AsyncioLoop_AddHandler(const char *name, int event, PyObject *const *args,
+                       Py_ssize_t nargs)
+{
+    AsyncioCore *core;
+    AsyncioHandle *handle = NULL, *previous;
+    PyObject *pyargs;
+    int fd;
+
+    if (Asyncio_CheckArgs(name, nargs, 3) ||
+        (fd = PyObject_AsFileDescriptor(args[1])) < 0 ||
+        !(core = Asyncio_GetOpenCore(args[0]))) {
+        return NULL;
+    }
+    if ((pyargs = Asyncio_Tuple(args + 3, nargs - 3))) {
+        handle = AsyncioHandle_New(&AsyncioHandleType, core, args[2],
+                                   pyargs, NULL);
+        Py_DECREF(pyargs);
+    }
+    if (handle) {
+        /* the fd table gets a reference, and we return one */
+        Py_INCREF(handle);
+        if (AsyncioCore_SetHandler(core, fd, event, handle, &previous)) {
+            Py_DECREF(handle);
+            Py_CLEAR(handle);
+        }
+        else if (previous) {
+            AsyncioHandle_Cancel(previous);
+            Py_DECREF(previous);
+        }
+    }
+    Py_DECREF(core);
+    return (PyObject *)handle;
+}
+
+
+/* remove the reader/writer of a fd */
+static PyObject *
+AsyncioLoop_RemoveHandler(const char *name, int event, PyObject *const *args,
+                          Py_ssize_t nargs)
+{
+    AsyncioCore *core;
+    AsyncioHandle *previous = NULL;
+    int fd, result;
+
+    if (nargs != 2) {
+        PyErr_Format(PyExc_TypeError, "%s() takes 1 argument", name);
+        return NULL;
+    }
+    if ((fd = PyObject_AsFileDescriptor(args[1])) < 0 ||
+        !(core = Asyncio_GetCore(args[0]))) {
+        return NULL;
+    }
+    result = core->closed ? 0 :
+             AsyncioCore_SetHandler(core, fd, event, NULL, &previous);
+    Py_DECREF(core);
+    if (result) {
+        return NULL;
+    }
+    if (previous) {
+        AsyncioHandle_Cancel(previous);
+        Py_DECREF(previous);
+    }
+    return PyBool_FromLong(previous != NULL);
+}
+
+
+/* EventLoop._add_reader(fd, callback, *args) -> Handle */
+static PyObject *
+AsyncioLoop__add_reader(PyObject *unused, PyObject *const *args,
+                        Py_ssize_t nargs)
+{
+    return AsyncioLoop_AddHandler("_add_reader", EV_READ, args, nargs);
+}
+
+
+/* EventLoop._remove_reader(fd) -> bool */
+static PyObject *
+AsyncioLoop__remove_reader(PyObject *unused, PyObject *const *args,
+                           Py_ssize_t nargs)
+{
+    return AsyncioLoop_RemoveHandler("_remove_reader", EV_READ, args, nargs);
+}
+
+
+/* EventLoop._add_writer(fd, callback, *args) -> Handle */
+static PyObject *
+AsyncioLoop__add_writer(PyObject *unused, PyObject *const *args,
+                        Py_ssize_t nargs)
+{
+    return AsyncioLoop_AddHandler("_add_writer", EV_WRITE, args, nargs);
+}
+
+
+/* EventLoop._remove_writer(fd) -> bool */
+static PyObject *
+AsyncioLoop__remove_writer(PyObject *unused, PyObject *const *args,
+                           Py_ssize_t nargs)
+{
+    return AsyncioLoop_RemoveHandler("_remove_writer", EV_WRITE, args, nargs);
+}
+
+
+/* EventLoop._run_once(), one Loop iteration then the handles that were
+   ready before it (the ones they queue wait for the next iteration) */
+static PyObject *
+AsyncioLoop__run_once(PyObject *unused, PyObject *const *args,
+                      Py_ssize_t nargs)
+{
+    AsyncioCore *core;
+    AsyncioHandle *handle;
+    PyObject *stopping;
+    Py_ssize_t count;
+    int flags;
+
+    if (!(core = Asyncio_GetCore(args[0]))) {
+        return NULL;
+    }
+    if (!(stopping = PyObject_GetAttrString(args[0], "_stopping"))) {
+        Py_DECREF(core);
+        return NULL;
+    }
+    flags = (core->first || stopping == Py_True) ? EVRUN_NOWAIT : EVRUN_ONCE;
+    Py_DECREF(stopping);
+    PYEV_BEGIN_LOCK(core->loop);
+    ev_run(core->loop->loop, flags);
+    PYEV_END_LOCK();
+    if (PyErr_Occurred()) {
+        Py_DECREF(core);
+        return NULL;
+    }
+    for (count = core->ready; count > 0; count--) {
+        if (!(handle = AsyncioCore_Pop(core))) {
+            break;
+        }
+        if (!handle->cancelled && AsyncioHandle_Run(handle)) {
+            Py_DECREF(handle);
+            Py_DECREF(core);
+            return NULL;
+        }
+        Py_DECREF(handle);
+    }
+    Py_DECREF(core);
+    Py_RETURN_NONE;
+}
+
+
+/* EventLoop.close() */
+static PyObject *
+AsyncioLoop_close(PyObject *unused, PyObject *const *args, Py_ssize_t nargs)
+{
+    PyObject *base, *result;
+    AsyncioCore *core;
+
+    if (!(base = PyObject_GetAttrString(args[0], "_pyev_base"))) {
+        return NULL;
+    }
+    result = PyObject_CallMethod(base, "close", "O", args[0]);
+    Py_DECREF(base);
+    if (!result) {
+        return NULL;
+    }
+    Py_DECREF(result);
+    if (!(core = Asyncio_GetCore(args[0]))) {
+        return NULL;
+    }
+    AsyncioCore_Close(core);
+    Py_DECREF(core);
+    Py_RETURN_NONE;
+}
+
+
+/* EventLoop._make_socket_transport(sock, protocol[, waiter=None, *,
+                                     extra=None, server=None]) -> Transport */
+static PyObject *
+AsyncioLoop__make_socket_transport(PyObject *unused, PyObject *args,
+                                   PyObject *kwargs)
+{
+    PyObject *self, *sock, *protocol, *waiter = NULL, *extra = NULL;
+    PyObject *server = NULL;
+
+    static char *kwlist[] = {"self", "sock", "protocol", "waiter",
+                             "extra", "server", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
+                                     "OOO|O$OO:_make_socket_transport", kwlist,
+                                     &self, &sock, &protocol, &waiter,
+                                     &extra, &server)) {
+        return NULL;
+    }
+    return AsyncioTransport_New(self, sock, protocol, waiter, extra, server);
+}
+
+
+/* EventLoop methods */
+static PyMethodDef AsyncioLoop_methods[] = {
+    {"__init__", (PyCFunction)AsyncioLoop___init__,
+     METH_FASTCALL, NULL},
+    {"time", (PyCFunction)AsyncioLoop_time,
+     METH_FASTCALL, NULL},
+    {"call_soon", (PyCFunction)AsyncioLoop_call_soon,
+     METH_FASTCALL | METH_KEYWORDS, NULL},
+    {"call_soon_threadsafe", (PyCFunction)AsyncioLoop_call_soon_threadsafe,
+     METH_FASTCALL | METH_KEYWORDS, NULL},
+    {"_call_soon", (PyCFunction)AsyncioLoop__call_soon,
+     METH_FASTCALL, NULL},
+    {"_add_callback", (PyCFunction)AsyncioLoop__add_callback,
+     METH_FASTCALL, NULL},
+    {"call_later", (PyCFunction)AsyncioLoop_call_later,
+     METH_FASTCALL | METH_KEYWORDS, NULL},
+    {"call_at", (PyCFunction)AsyncioLoop_call_at,
+     METH_FASTCALL | METH_KEYWORDS, NULL},
+    {"_add_reader", (PyCFunction)AsyncioLoop__add_reader,
+     METH_FASTCALL, NULL},
+    {"_remove_reader", (PyCFunction)AsyncioLoop__remove_reader,
+     METH_FASTCALL, NULL},
+    {"_add_writer", (PyCFunction)AsyncioLoop__add_writer,
+     METH_FASTCALL, NULL},
+    {"_remove_writer", (PyCFunction)AsyncioLoop__remove_writer,
+     METH_FASTCALL, NULL},
+    {"_make_socket_transport", (PyCFunction)AsyncioLoop__make_socket_transport,
+     METH_VARARGS | METH_KEYWORDS, NULL},
+    {"_run_once", (PyCFunction)AsyncioLoop__run_once,
+     METH_FASTCALL, NULL},
+    {"close", (PyCFunction)AsyncioLoop_close,
+     METH_FASTCALL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/*******************************************************************************
+* pyev.asyncio
+*******************************************************************************/
+
+/* pyev.asyncio.new_event_loop() -> EventLoop */
+static PyObject *
+Asyncio_new_event_loop(PyObject *module)
+{
+    PyObject *loop = PyObject_GetAttrString(module, "EventLoop"), *result;
+
+    if (!loop) {
+        return NULL;
+    }
+    result = PyObject_CallFunctionObjArgs(loop, NULL);
+    Py_DECREF(loop);
+    return result;
+}
+
+static PyMethodDef Asyncio_new_event_loop_def = {
+    "new_event_loop", (PyCFunction)Asyncio_new_event_loop,
+    METH_NOARGS, "new_event_loop() -> EventLoop"
+};
+
+
+/* pyev.asyncio.EventLoop.__doc__ */
+PyDoc_STRVAR(AsyncioLoop_doc,
+"EventLoop()");
+
+/* pyev.asyncio.EventLoopPolicy.__doc__ */
+PyDoc_STRVAR(AsyncioPolicy_doc,
+"EventLoopPolicy()");
+
+
+/* subclass base with dict */
+PyObject *
+Asyncio_Subclass(const char *name, PyObject *base, PyObject *dict)
+{
+    if (PyDict_SetItemString(dict, "__module__", Asyncio_ModuleName)) {
+        return NULL;
+    }
+    return PyObject_CallFunction((PyObject *)&PyType_Type, "s(O)O",
+                                 name, base, dict);
+}
+
+
+/* EventLoop, a subclass of asyncio.SelectorEventLoop */
+PyObject *
+Asyncio_NewEventLoopType(PyObject *asyncio)
+{
+    PyObject *base, *dict, *func, *method, *result = NULL;
+    PyMethodDef *def;
+
+    if (!(base = PyObject_GetAttrString(asyncio, "SelectorEventLoop"))) {
+        return NULL;
+    }
+    dict = Py_BuildValue("{s:s,s:O}", "__doc__", AsyncioLoop_doc,
+                         "_pyev_base", base);
+    if (!dict) {
+        Py_DECREF(base);
+        return NULL;
+    }
+    for (def = AsyncioLoop_methods; def->ml_name; def++) {
+        /* plain functions, bound to the instance like Python ones */
+        func = PyCFunction_NewEx(def, NULL, Asyncio_ModuleName);
+        if (!func) {
+            goto fail;
+        }
+        method = PyInstanceMethod_New(func);
+        Py_DECREF(func);
+        if (!method || PyDict_SetItemString(dict, def->ml_name, method)) {
+            Py_XDECREF(method);
+            goto fail;
+        }
+        Py_DECREF(method);
+    }
+    result = Asyncio_Subclass("EventLoop", base, dict);
+
+fail:
+    Py_DECREF(dict);
+    Py_DECREF(base);
+    return result;
+}
+
+
+/* EventLoopPolicy, a subclass of asyncio.DefaultEventLoopPolicy */
+PyObject *
+Asyncio_NewEventLoopPolicyType(PyObject *asyncio, PyObject *loop)
+{
+    PyObject *base, *dict, *result = NULL;
+
+    if (!(base = PyObject_GetAttrString(asyncio, "DefaultEventLoopPolicy"))) {
+        return NULL;
+    }
+    dict = Py_BuildValue("{s:s,s:O}", "__doc__", AsyncioPolicy_doc,
+                         "_loop_factory", loop);
+    if (dict) {
+        result = Asyncio_Subclass("EventLoopPolicy", base, dict);
+        Py_DECREF(dict);
+    }
+    Py_DECREF(base);
+    return result;
+}
+
+
+/* fill pyev.asyncio (imports asyncio, hence not done with pyev) */
+int
+Asyncio_Init(PyObject *module)
+{
+    PyObject *asyncio, *loop = NULL, *policy = NULL, *func;
+
+    if (PyType_Ready(&AsyncioCoreType) ||
+        PyType_Ready(&AsyncioHandleType) ||
+        PyType_Ready(&AsyncioTimerHandleType)) {
+        return -1;
+    }
+    if (!(asyncio = PyImport_ImportModule("asyncio"))) {
+        return -1;
+    }
+    if (AsyncioTransport_Init()) {
+        goto fail;
+    }
+    if (!(loop = Asyncio_NewEventLoopType(asyncio)) ||
+        !(policy = Asyncio_NewEventLoopPolicyType(asyncio, loop)) ||
+        !(func = PyCFunction_NewEx(&Asyncio_new_event_loop_def, module,
+                                   Asyncio_ModuleName))) {
+        goto fail;
+    }
+    if (PyModule_AddObject(module, "new_event_loop", func)) {
+        Py_DECREF(func);
+        goto fail;
+    }
+    if (_PyModule_AddType(module, "Handle", &AsyncioHandleType) ||
+        _PyModule_AddType(module, "TimerHandle", &AsyncioTimerHandleType) ||
+        _PyModule_AddType(module, "Transport", &AsyncioTransportType) ||
+        PyModule_AddObject(module, "EventLoop", loop)) {
+        goto fail;
+    }
+    loop = NULL;
+    if (PyModule_AddObject(module, "EventLoopPolicy", policy)) {
+        goto fail;
+    }
+    Py_DECREF(asyncio);
+    return 0;
+
+fail:
+    Py_XDECREF(policy);
+    Py_XDECREF(loop);
+    Py_DECREF(asyncio);
+    return -1;
+}
+
+
+/* pyev.asyncio.__getattr__(name), fills pyev.asyncio the first time one of
+   its attributes is asked for */
+static PyObject *
+Asyncio___getattr__(PyObject *module, PyObject *name)
+{
+    PyObject *dict = PyModule_GetDict(module), *result;
+    const char *s = PyUnicode_Check(name) ? PyUnicode_AsUTF8(name) : NULL;
+    size_t len = s ? strlen(s) : 0;
+
+    /* not for special names, import and introspection look them up */
+    if (s && (len < 4 || strncmp(s, "__", 2) || strcmp(s + len - 2, "__"))) {
+        if (!PyDict_GetItemString(dict, "EventLoop") &&
+            Asyncio_Init(module)) {
+            return NULL;
+        }
+        if ((result = PyDict_GetItemWithError(dict, name))) {
+            Py_INCREF(result);
+            return result;
+        }
+        if (PyErr_Occurred()) {
+            return NULL;
+        }
+    }
+    else if (PyErr_Occurred()) {
+        return NULL;
+    }
+    PyErr_Format(PyExc_AttributeError,
+                 "module 'pyev.asyncio' has no attribute %R", name);
+    return NULL;
+}
+
+static PyMethodDef Asyncio___getattr___def = {
+    "__getattr__", (PyCFunction)Asyncio___getattr__, METH_O, NULL
+};
+
+
+/* pyev.asyncio.__dir__(), fills pyev.asyncio too */
+static PyObject *
+Asyncio___dir__(PyObject *module, PyObject *unused)
+{
+    PyObject *dict = PyModule_GetDict(module), *result;
+
+    if (!PyDict_GetItemString(dict, "EventLoop") && Asyncio_Init(module)) {
+        return NULL;
+    }
+    if ((result = PyDict_Keys(dict)) && PyList_Sort(result)) {
+        Py_CLEAR(result);
+    }
+    return result;
+}
+
+static PyMethodDef Asyncio___dir___def = {
+    "__dir__", (PyCFunction)Asyncio___dir__, METH_NOARGS, NULL
+};
+
+
+/* pyev.asyncio, empty until it is used (see Asyncio___getattr__) */
+PyObject *
+Asyncio_New(void)
+{
+    PyObject *module, *func, *all;
+
+    if (!Asyncio_CoreName &&
+        !(Asyncio_CoreName = PyUnicode_InternFromString("_pyev_core"))) {
+        return NULL;
+    }
+    if (!Asyncio_ModuleName &&
+        !(Asyncio_ModuleName = PyUnicode_InternFromString("pyev.asyncio"))) {
+        return NULL;
+    }
+    if (!(module = PyModule_NewObject(Asyncio_ModuleName))) {
+        return NULL;
+    }
+    if (PyModule_AddStringConstant(module, "__doc__",
+                                   "asyncio event loop running on a "
+                                   "pyev.Loop.")) {
+        Py_DECREF(module);
+        return NULL;
+    }
+    if (!(func = PyCFunction_NewEx(&Asyncio___getattr___def, module,
+                                   Asyncio_ModuleName)) ||
+        PyModule_AddObject(module, "__getattr__", func)) {
+        Py_XDECREF(func);
+        Py_DECREF(module);
+        return NULL;
+    }
+    if (!(func = PyCFunction_NewEx(&Asyncio___dir___def, module,
+                                   Asyncio_ModuleName)) ||
+        PyModule_AddObject(module, "__dir__", func)) {
+        Py_XDECREF(func);
+        Py_DECREF(module);
+        return NULL;
+    }
+    /* from pyev.asyncio import * goes through __getattr__ with these */
+    if (!(all = Py_BuildValue("[ssssss]", "EventLoop", "EventLoopPolicy",
+                              "Handle", "TimerHandle", "Transport",
+                              "new_event_loop")) ||
+        PyModule_AddObject(module, "__all__", all)) {
+        Py_XDECREF(all);
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
@@ -0,0 +1,1465 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_TRANSPORT_READ_SIZE 65536
+#define PYEV_TRANSPORT_IOV_MAX 64
+#define PYEV_TRANSPORT_HIGH_WATER 65536
+
+
+/* asyncio.BufferedProtocol and asyncio.trsock.TransportSocket (3.8+), cached
+   for the main interpreter only, subinterpreters have their own asyncio (see
+   AsyncioTransport_Class) */
+static PyObject *Asyncio_BufferedProtocol = NULL;
+#if PY_VERSION_HEX >= 0x03080000
+static PyObject *Asyncio_TransportSocket = NULL;
+#endif
+
+
+/* protocol methods, interned once */
+enum {
+    Asyncio_connection_made,
+    Asyncio_connection_lost,
+    Asyncio_data_received,
+    Asyncio_eof_received,
+    Asyncio_get_buffer,
+    Asyncio_buffer_updated,
+    Asyncio_pause_writing,
+    Asyncio_resume_writing,
+    Asyncio_names_count
+};
+
+static const char *Asyncio_names_str[Asyncio_names_count] = {
+    "connection_made",
+    "connection_lost",
+    "data_received",
+    "eof_received",
+    "get_buffer",
+    "buffer_updated",
+    "pause_writing",
+    "resume_writing",
+};
+
+static PyObject *Asyncio_names[Asyncio_names_count];
+
+
+/* module.name, from the cache in the main interpreter */
+PyObject *
+AsyncioTransport_Class(PyObject **cache, const char *module, const char *name)
+{
+    PyObject *pymodule, *result;
+    int is_main = (PYEV_INTERPRETER() == PyInterpreterState_Main());
+
+    if (is_main && *cache) {
+        Py_INCREF(*cache);
+        return *cache;
+    }
+    if (!(pymodule = PyImport_ImportModule(module))) {
+        return NULL;
+    }
+    result = PyObject_GetAttrString(pymodule, name);
+    Py_DECREF(pymodule);
+    if (is_main && result) {
+        Py_INCREF(result);
+        *cache = result;
+    }
+    return result;
+}
+
+
+/* what the transports need from asyncio */
+int
+AsyncioTransport_Init(void)
+{
+    int i;
+
+    for (i = 0; i < Asyncio_names_count; i++) {
+        if (!Asyncio_names[i] &&
+            !(Asyncio_names[i] =
+              PyUnicode_InternFromString(Asyncio_names_str[i]))) {
+            return -1;
+        }
+    }
+    return PyType_Ready(&AsyncioTransportType);
+}
+
+
+/* protocol.name(arg), arg can be NULL */
+PyObject *
+AsyncioTransport_CallProtocol(AsyncioTransport *self, int name, PyObject *arg)
+{
+#if PY_VERSION_HEX >= 0x03090000
+    if (!arg) {
+        return PyObject_CallMethodNoArgs(self->protocol, Asyncio_names[name]);
+    }
+    return PyObject_CallMethodOneArg(self->protocol, Asyncio_names[name], arg);
+#else
+    return PyObject_CallMethodObjArgs(self->protocol, Asyncio_names[name],
+                                      arg, NULL);
+#endif
+}
+
+
+/* call_soon(self.name, arg) */
+int
+AsyncioTransport_CallSoon(AsyncioTransport *self, const char *name,
+                          PyObject *arg)
+{
+    PyObject *callback, *args, *handle = NULL;
+
+    if (!(callback = PyObject_GetAttrString((PyObject *)self, name))) {
+        return -1;
+    }
+    if ((args = arg ? PyTuple_Pack(1, arg) : PyTuple_New(0))) {
+        handle = AsyncioLoop_CallSoon(self->loop, callback, args, NULL);
+        Py_DECREF(args);
+    }
+    Py_DECREF(callback);
+    if (!handle) {
+        return -1;
+    }
+    Py_DECREF(handle);
+    return 0;
+}
+
+
+/* start or stop one of the watchers, while any of them is active the loop
+   holds a reference to the transport (as the selector would, through the
+   handles) */
+void
+AsyncioTransport_Watch(AsyncioTransport *self, ev_io *io, int start)
+{
+    ev_io *reader = &self->reader, *writer = &self->writer;
+    int before = ev_is_active(reader) || ev_is_active(writer), after;
+
+    if (start && !self->core->closed) {
+        ev_io_start(self->core->loop->loop, io);
+    }
+    else {
+        ev_io_stop(self->core->loop->loop, io);
+    }
+    after = ev_is_active(reader) || ev_is_active(writer);
+    if (after && !before) {
+        Py_INCREF(self);
+    }
+    else if (before && !after) {
+        /* callers hold their own reference */
+        Py_DECREF(self);
+    }
+}
+
+
+/* release all the buffers still waiting in the write queue */
+void
+AsyncioTransport_ClearQueue(AsyncioTransport *self)
+{
+    while (self->queue_head < self->queue_tail) {
+        PyBuffer_Release(&self->queue[self->queue_head++]);
+    }
+    self->queue_head = self->queue_tail = 0;
+    self->offset = self->queued = 0;
+}
+
+
+/* append a buffer to the write queue (takes over view), data the caller
+   could modify afterwards is copied */
+int
+AsyncioTransport_Enqueue(AsyncioTransport *self, Py_buffer *view,
+                         Py_ssize_t offset)
+{
+    Py_ssize_t length = self->queue_tail - self->queue_head;
+    Py_ssize_t size;
+    Py_buffer *queue, copy;
+    PyObject *data;
+
+    if (!view->obj || !PyBytes_CheckExact(view->obj)) {
+        data = PyBytes_FromStringAndSize((char *)view->buf + offset,
+                                         view->len - offset);
+        PyBuffer_Release(view);
+        if (!data) {
+            return -1;
+        }
+        if (PyObject_GetBuffer(data, &copy, PyBUF_SIMPLE)) {
+            Py_DECREF(data);
+            return -1;
+        }
+        Py_DECREF(data);
+        view = &copy;
+        offset = 0;
+    }
+    if (self->queue_tail == self->queue_size) {
+        if (self->queue_head) {
+            memmove(self->queue, self->queue + self->queue_head,
+                    length * sizeof(Py_buffer));
+            self->queue_head = 0;
+            self->queue_tail = length;
+        }
+        else {
+            size = self->queue_size ? self->queue_size * 2 : 8;
+            queue = PyMem_Realloc(self->queue, size * sizeof(Py_buffer));
+            if (!queue) {
+                PyBuffer_Release(view);
+                PyErr_NoMemory();
+                return -1;
+            }
+            self->queue = queue;
+            self->queue_size = size;
+        }
+    }
+    self->queue[self->queue_tail++] = *view;
+    self->queued += view->len - offset;
+    if (!length) {
+        self->offset = offset;
+    }
+    return 0;
+}
+
+
+/* drop written bytes from the head of the write queue */
+void
+AsyncioTransport_Dequeue(AsyncioTransport *self, Py_ssize_t written)
+{
+    Py_buffer *view;
+
+    self->queued -= written;
+    while (written) {
+        view = &self->queue[self->queue_head];
+        if (written < view->len - self->offset) {
+            self->offset += written;
+            return;
+        }
+        written -= view->len - self->offset;
+        PyBuffer_Release(view);
+        self->queue_head++;
+        self->offset = 0;
+    }
+    if (self->queue_head == self->queue_tail) {
+        self->queue_head = self->queue_tail = 0;
+    }
+}
+
+
+/* write as much of the queue as the socket accepts, -1 on error */
+int
+AsyncioTransport_Flush(AsyncioTransport *self)
+{
+    struct iovec iov[PYEV_TRANSPORT_IOV_MAX];
+    Py_ssize_t i, result, length;
+    int count;
+
+    while (self->queue_head < self->queue_tail) {
+        length = 0;
+        for (i = self->queue_head, count = 0;
+             i < self->queue_tail && count < PYEV_TRANSPORT_IOV_MAX;
+             i++, count++) {
+            iov[count].iov_base = (char *)self->queue[i].buf;
+            iov[count].iov_len = self->queue[i].len;
+            length += self->queue[i].len;
+        }
+        iov[0].iov_base = (char *)iov[0].iov_base + self->offset;
+        iov[0].iov_len -= self->offset;
+        length -= self->offset;
+        result = writev(self->fd, iov, count);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            PyErr_SetFromErrno(PyExc_OSError);
+            return -1;
+        }
+        AsyncioTransport_Dequeue(self, result);
+        if (result < length) {
+            break;
+        }
+    }
+    return 0;
+}
+
+
+/* close without flushing, connection_lost(exc) is called soon */
+int
+AsyncioTransport_ForceClose(AsyncioTransport *self, PyObject *exc)
+{
+    if (self->conn_lost) {
+        return 0;
+    }
+    if (self->queue_head < self->queue_tail) {
+        AsyncioTransport_ClearQueue(self);
+        AsyncioTransport_Watch(self, &self->writer, 0);
+    }
+    if (!self->closing) {
+        self->closing = 1;
+        AsyncioTransport_Watch(self, &self->reader, 0);
+    }
+    self->conn_lost++;
+    return AsyncioTransport_CallSoon(self, "_call_connection_lost", exc);
+}
+
+
+/* close once the queue is flushed */
+int
+AsyncioTransport_Close(AsyncioTransport *self)
+{
+    if (self->closing) {
+        return 0;
+    }
+    self->closing = 1;
+    AsyncioTransport_Watch(self, &self->reader, 0);
+    if (self->queue_head == self->queue_tail) {
+        self->conn_lost++;
+        AsyncioTransport_Watch(self, &self->writer, 0);
+        return AsyncioTransport_CallSoon(self, "_call_connection_lost", NULL);
+    }
+    return 0;
+}
+
+
+/* report the current exception with message, -1 if it must propagate
+   (SystemExit, KeyboardInterrupt) */
+int
+AsyncioTransport_Report(AsyncioTransport *self, const char *message,
+                        int force_close)
+{
+    PyObject *value;
+
+    if (PyErr_ExceptionMatches(PyExc_SystemExit) ||
+        PyErr_ExceptionMatches(PyExc_KeyboardInterrupt)) {
+        return -1;
+    }
+    value = Asyncio_FetchError();
+    /* OSErrors are expected (and only logged in debug mode by asyncio) */
+    if (self->loop && !PyErr_GivenExceptionMatches(value, PyExc_OSError)) {
+        Asyncio_CallExceptionHandler(self->loop,
+            Py_BuildValue("{s:s,s:O,s:O,s:O}", "message", message,
+                          "exception", value ? value : Py_None,
+                          "transport", self,
+                          "protocol", self->protocol ? self->protocol : Py_None));
+    }
+    if (force_close && AsyncioTransport_ForceClose(self, value)) {
+        PyErr_WriteUnraisable((PyObject *)self);
+    }
+    Py_XDECREF(value);
+    return 0;
+}
+
+
+/* _fatal_error() */
+int
+AsyncioTransport_Fatal(AsyncioTransport *self, const char *message)
+{
+    return AsyncioTransport_Report(self, message, 1);
+}
+
+
+/* protocol.pause_writing() when the queue goes over the high water mark */
+int
+AsyncioTransport_MaybePause(AsyncioTransport *self)
+{
+    PyObject *result;
+
+    if (self->queued <= self->high || self->protocol_paused ||
+        !self->protocol) {
+        return 0;
+    }
+    self->protocol_paused = 1;
+    if (!(result = AsyncioTransport_CallProtocol(self, Asyncio_pause_writing,
+                                                 NULL))) {
+        return AsyncioTransport_Report(self,
+                                       "protocol.pause_writing() failed", 0);
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+/* protocol.resume_writing() when the queue goes under the low water mark */
+int
+AsyncioTransport_MaybeResume(AsyncioTransport *self)
+{
+    PyObject *result;
+
+    if (self->queued > self->low || !self->protocol_paused ||
+        !self->protocol) {
+        return 0;
+    }
+    self->protocol_paused = 0;
+    if (!(result = AsyncioTransport_CallProtocol(self, Asyncio_resume_writing,
+                                                 NULL))) {
+        return AsyncioTransport_Report(self,
+                                       "protocol.resume_writing() failed", 0);
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+/* protocol.connection_lost(exc) and release everything */
+int
+AsyncioTransport_ConnectionLost(AsyncioTransport *self, PyObject *exc)
+{
+    PyObject *type, *value, *traceback, *result = NULL;
+
+    if (self->protocol) {
+        result = AsyncioTransport_CallProtocol(self, Asyncio_connection_lost,
+                                               exc ? exc : Py_None);
+    }
+    /* whatever happened, the socket is closed */
+    PyErr_Fetch(&type, &value, &traceback);
+    AsyncioTransport_Watch(self, &self->reader, 0);
+    AsyncioTransport_Watch(self, &self->writer, 0);
+    if (self->sock) {
+        Py_XDECREF(result);
+        result = PyObject_CallMethod(self->sock, "close", NULL);
+        Py_CLEAR(self->sock);
+    }
+    Py_CLEAR(self->protocol);
+    Py_CLEAR(self->loop);
+    if (self->server) {
+        Py_XDECREF(result);
+#if PY_VERSION_HEX >= 0x030D0000
+        result = PyObject_CallMethod(self->server, "_detach", "O", self);
+#else
+        result = PyObject_CallMethod(self->server, "_detach", NULL);
+#endif
+        Py_CLEAR(self->server);
+    }
+    if (type) {
+        PyErr_Restore(type, value, traceback);
+        Py_XDECREF(result);
+        return -1;
+    }
+    if (!result) {
+        return -1;
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+/* EOF on the socket */
+int
+AsyncioTransport_OnEof(AsyncioTransport *self)
+{
+    PyObject *result;
+    int keep_open;
+
+    if (!(result = AsyncioTransport_CallProtocol(self, Asyncio_eof_received,
+                                                 NULL))) {
+        return AsyncioTransport_Fatal(self,
+            "Fatal error: protocol.eof_received() call failed.");
+    }
+    keep_open = PyObject_IsTrue(result);
+    Py_DECREF(result);
+    if (keep_open < 0) {
+        return AsyncioTransport_Fatal(self,
+            "Fatal error: protocol.eof_received() call failed.");
+    }
+    if (keep_open) {
+        /* the protocol can still write */
+        AsyncioTransport_Watch(self, &self->reader, 0);
+        return 0;
+    }
+    if (AsyncioTransport_Close(self)) {
+        return AsyncioTransport_Report(self, "Fatal error on transport", 0);
+    }
+    return 0;
+}
+
+
+/* recv() and protocol.data_received() */
+int
+AsyncioTransport_ReadData(AsyncioTransport *self)
+{
+    char buffer[PYEV_TRANSPORT_READ_SIZE];
+    PyObject *data, *result;
+    Py_ssize_t count;
+
+    do {
+        count = recv(self->fd, buffer, PYEV_TRANSPORT_READ_SIZE, 0);
+    } while (count < 0 && errno == EINTR);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        PyErr_SetFromErrno(PyExc_OSError);
+        return AsyncioTransport_Fatal(self,
+                                      "Fatal read error on socket transport");
+    }
+    if (!count) {
+        return AsyncioTransport_OnEof(self);
+    }
+    if (!(data = PyBytes_FromStringAndSize(buffer, count))) {
+        return AsyncioTransport_Fatal(self,
+                                      "Fatal read error on socket transport");
+    }
+    result = AsyncioTransport_CallProtocol(self, Asyncio_data_received, data);
+    Py_DECREF(data);
+    if (!result) {
+        return AsyncioTransport_Fatal(self,
+            "Fatal error: protocol.data_received() call failed.");
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+/* protocol.get_buffer(), recv_into() and protocol.buffer_updated() */
+int
+AsyncioTransport_ReadBuffered(AsyncioTransport *self)
+{
+    PyObject *buffer, *result;
+    Py_buffer view;
+    Py_ssize_t count;
+    int error;
+
+    buffer = PyObject_CallMethod(self->protocol, "get_buffer", "i", -1);
+    if (!buffer) {
+        return AsyncioTransport_Fatal(self,
+            "Fatal error: protocol.get_buffer() call failed.");
+    }
+    error = PyObject_GetBuffer(buffer, &view, PyBUF_WRITABLE);
+    Py_DECREF(buffer);
+    if (!error && !view.len) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_RuntimeError,
+                        "get_buffer() returned an empty buffer");
+        error = -1;
+    }
+    if (error) {
+        return AsyncioTransport_Fatal(self,
+            "Fatal error: protocol.get_buffer() call failed.");
+    }
+    do {
+        count = recv(self->fd, view.buf, view.len, 0);
+    } while (count < 0 && errno == EINTR);
+    PyBuffer_Release(&view);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        PyErr_SetFromErrno(PyExc_OSError);
+        return AsyncioTransport_Fatal(self,
+                                      "Fatal read error on socket transport");
+    }
+    if (!count) {
+        return AsyncioTransport_OnEof(self);
+    }
+    if (!(buffer = PyLong_FromSsize_t(count))) {
+        return AsyncioTransport_Fatal(self,
+            "Fatal error: protocol.buffer_updated() call failed.");
+    }
+    result = AsyncioTransport_CallProtocol(self, Asyncio_buffer_updated,
+                                           buffer);
+    Py_DECREF(buffer);
+    if (!result) {
+        return AsyncioTransport_Fatal(self,
+            "Fatal error: protocol.buffer_updated() call failed.");
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+/* reader callback */
+static void
+AsyncioTransport_ReadCallback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    AsyncioTransport *self = io->data;
+    int result = 0;
+
+    if (PyErr_Occurred() || self->conn_lost) {
+        return;
+    }
+    Py_INCREF(self);
+    if (self->buffered) {
+        result = AsyncioTransport_ReadBuffered(self);
+    }
+    else {
+        result = AsyncioTransport_ReadData(self);
+    }
+    if (result) {
+        PYEV_LOOP_EXIT(loop);
+    }
+    Py_DECREF(self);
+}
+
+
+/* the queue is flushed (or dropped), what was waiting for it can go on */
+int
+AsyncioTransport_Drained(AsyncioTransport *self)
+{
+    if (self->queue_head < self->queue_tail) {
+        return 0;
+    }
+    AsyncioTransport_Watch(self, &self->writer, 0);
+    if (self->closing) {
+        if (AsyncioTransport_ConnectionLost(self, NULL)) {
+            return AsyncioTransport_Report(self, "Fatal error on transport",
+                                           0);
+        }
+    }
+    else if (self->eof && shutdown(self->fd, SHUT_WR)) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        return AsyncioTransport_Fatal(self,
+                                      "Fatal write error on socket transport");
+    }
+    return 0;
+}
+
+
+/* flush the queue, start the writer if something is left */
+int
+AsyncioTransport_WriteReady(AsyncioTransport *self)
+{
+    if (AsyncioTransport_Flush(self)) {
+        AsyncioTransport_ClearQueue(self);
+        AsyncioTransport_Watch(self, &self->writer, 0);
+        return AsyncioTransport_Fatal(self,
+                                      "Fatal write error on socket transport");
+    }
+    if (AsyncioTransport_MaybeResume(self)) {
+        return -1;
+    }
+    if (self->queue_head < self->queue_tail) {
+        AsyncioTransport_Watch(self, &self->writer, 1);
+        return 0;
+    }
+    return AsyncioTransport_Drained(self);
+}
+
+
+/* writer callback */
+static void
+AsyncioTransport_WriteCallback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    AsyncioTransport *self = io->data;
+
+    if (PyErr_Occurred() || self->conn_lost) {
+        return;
+    }
+    Py_INCREF(self);
+    if (AsyncioTransport_WriteReady(self)) {
+        PYEV_LOOP_EXIT(loop);
+    }
+    Py_DECREF(self);
+}
+
+
+/* get a buffer on data, which must be bytes, bytearray or memoryview */
+int
+AsyncioTransport_GetBuffer(PyObject *data, Py_buffer *view)
+{
+    if (!PyBytes_Check(data) && !PyByteArray_Check(data) &&
+        !PyMemoryView_Check(data)) {
+        PyErr_Format(PyExc_TypeError,
+                     "data argument must be a bytes-like object, not '%.200s'",
+                     Py_TYPE(data)->tp_name);
+        return -1;
+    }
+    return PyObject_GetBuffer(data, view, PyBUF_SIMPLE);
+}
+
+
+int
+AsyncioTransport_SetProtocol(AsyncioTransport *self, PyObject *protocol)
+{
+    PyObject *cls = AsyncioTransport_Class(&Asyncio_BufferedProtocol,
+                                           "asyncio", "BufferedProtocol");
+    int buffered;
+
+    if (!cls) {
+        return -1;
+    }
+    buffered = PyObject_IsInstance(protocol, cls);
+    Py_DECREF(cls);
+    if (buffered < 0) {
+        return -1;
+    }
+    self->buffered = buffered;
+    Py_INCREF(protocol);
+    Py_XSETREF(self->protocol, protocol);
+    return 0;
+}
+
+
+int
+AsyncioTransport_SetLimits(AsyncioTransport *self, PyObject *pyhigh,
+                           PyObject *pylow)
+{
+    Py_ssize_t high = -1, low = -1;
+
+    if (pyhigh && pyhigh != Py_None &&
+        (high = PyNumber_AsSsize_t(pyhigh, PyExc_OverflowError)) == -1 &&
+        PyErr_Occurred()) {
+        return -1;
+    }
+    if (pylow && pylow != Py_None &&
+        (low = PyNumber_AsSsize_t(pylow, PyExc_OverflowError)) == -1 &&
+        PyErr_Occurred()) {
+        return -1;
+    }
+    if (high == -1 && (!pyhigh || pyhigh == Py_None)) {
+        high = (low == -1 && (!pylow || pylow == Py_None)) ?
+               PYEV_TRANSPORT_HIGH_WATER : 4 * low;
+    }
+    if (low == -1 && (!pylow || pylow == Py_None)) {
+        low = high / 4;
+    }
+    if (!(high >= low && low >= 0)) {
+        PyErr_Format(PyExc_ValueError,
+                     "high (%zd) must be >= low (%zd) must be >= 0",
+                     high, low);
+        return -1;
+    }
+    self->high = high;
+    self->low = low;
+    return 0;
+}
+
+
+/* extra[key] = sock.method(), None on OSError */
+int
+AsyncioTransport_SetSockInfo(PyObject *extra, const char *key, PyObject *sock,
+                             const char *method)
+{
+    PyObject *value = PyObject_CallMethod(sock, method, NULL);
+    int result;
+
+    if (!value) {
+        if (!PyErr_ExceptionMatches(PyExc_OSError)) {
+            return -1;
+        }
+        PyErr_Clear();
+        Py_INCREF(Py_None);
+        value = Py_None;
+    }
+    result = PyDict_SetItemString(extra, key, value);
+    Py_DECREF(value);
+    return result;
+}
+
+
+/* a transport on a connected socket */
+PyObject *
+AsyncioTransport_New(PyObject *loop, PyObject *sock, PyObject *protocol,
+                     PyObject *waiter, PyObject *extra, PyObject *server)
+{
+    AsyncioTransport *self;
+    PyObject *transports, *pysock, *result;
+    AsyncioCore *core;
+    ev_io *io;
+    int fd, nodelay = 1;
+
+    if ((fd = PyObject_AsFileDescriptor(sock)) < 0 ||
+        !(core = Asyncio_GetOpenCore(loop))) {
+        return NULL;
+    }
+    self = (AsyncioTransport *)
+        AsyncioTransportType.tp_alloc(&AsyncioTransportType, 0);
+    if (!self) {
+        Py_DECREF(core);
+        return NULL;
+    }
+    self->core = core;
+    Py_INCREF(loop);
+    self->loop = loop;
+    Py_INCREF(sock);
+    self->sock = sock;
+    self->fd = fd;
+    io = &self->reader;
+    ev_io_init(io, AsyncioTransport_ReadCallback, fd, EV_READ);
+    io->data = self;
+    io = &self->writer;
+    ev_io_init(io, AsyncioTransport_WriteCallback, fd, EV_WRITE);
+    io->data = self;
+    self->high = PYEV_TRANSPORT_HIGH_WATER;
+    self->low = PYEV_TRANSPORT_HIGH_WATER / 4;
+    if (AsyncioTransport_SetProtocol(self, protocol)) {
+        goto fail;
+    }
+    /* extra info */
+    self->extra = (extra && extra != Py_None) ?
+                  PyDict_Copy(extra) : PyDict_New();
+    if (!self->extra) {
+        goto fail;
+    }
+#if PY_VERSION_HEX >= 0x03080000
+    pysock = AsyncioTransport_Class(&Asyncio_TransportSocket, "asyncio.trsock",
+                                    "TransportSocket");
+    if (pysock) {
+        Py_SETREF(pysock, PyObject_CallFunctionObjArgs(pysock, sock, NULL));
+    }
+#else
+    Py_INCREF(sock);
+    pysock = sock;
+#endif
+    if (!pysock || PyDict_SetItemString(self->extra, "socket", pysock)) {
+        Py_XDECREF(pysock);
+        goto fail;
+    }
+    Py_DECREF(pysock);
+    if (AsyncioTransport_SetSockInfo(self->extra, "sockname", sock,
+                                     "getsockname") ||
+        (!PyDict_GetItemString(self->extra, "peername") &&
+         AsyncioTransport_SetSockInfo(self->extra, "peername", sock,
+                                      "getpeername"))) {
+        goto fail;
+    }
+    /* attach to the server and the loop */
+    if (server && server != Py_None) {
+#if PY_VERSION_HEX >= 0x030D0000
+        result = PyObject_CallMethod(server, "_attach", "O", self);
+#else
+        result = PyObject_CallMethod(server, "_attach", NULL);
+#endif
+        if (!result) {
+            goto fail;
+        }
+        Py_DECREF(result);
+        Py_INCREF(server);
+        self->server = server;
+    }
+    transports = PyObject_GetAttrString(loop, "_transports");
+    if (!transports) {
+        goto fail;
+    }
+    pysock = PyLong_FromLong(fd);
+    if (!pysock || PyObject_SetItem(transports, pysock, (PyObject *)self)) {
+        Py_XDECREF(pysock);
+        Py_DECREF(transports);
+        goto fail;
+    }
+    Py_DECREF(pysock);
+    Py_DECREF(transports);
+    /* disable Nagle, fails harmlessly on non TCP sockets */
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    /* connection_made(), then reading starts and the waiter is woken up */
+    if (!(result = PyObject_GetAttr(protocol,
+                                    Asyncio_names[Asyncio_connection_made]))) {
+        goto fail;
+    }
+    pysock = PyTuple_Pack(1, self);
+    if (!pysock) {
+        Py_DECREF(result);
+        goto fail;
+    }
+    waiter = (waiter && waiter != Py_None) ? waiter : NULL;
+    Py_XINCREF(waiter);
+    self->waiter = waiter;
+    extra = AsyncioLoop_CallSoon(loop, result, pysock, NULL);
+    Py_DECREF(pysock);
+    Py_DECREF(result);
+    if (!extra) {
+        goto fail;
+    }
+    Py_DECREF(extra);
+    if (AsyncioTransport_CallSoon(self, "_connected", NULL)) {
+        goto fail;
+    }
+    return (PyObject *)self;
+
+fail:
+    Py_DECREF(self);
+    return NULL;
+}
+
+
+/*******************************************************************************
+* AsyncioTransportType
+*******************************************************************************/
+
+/* AsyncioTransportType.tp_doc */
+PyDoc_STRVAR(AsyncioTransport_tp_doc,
+"Transport");
+
+
+/* AsyncioTransportType.tp_traverse */
+static int
+AsyncioTransport_tp_traverse(AsyncioTransport *self, visitproc visit,
+                             void *arg)
+{
+    Py_VISIT(self->core);
+    Py_VISIT(self->loop);
+    Py_VISIT(self->sock);
+    Py_VISIT(self->protocol);
+    Py_VISIT(self->server);
+    Py_VISIT(self->waiter);
+    Py_VISIT(self->extra);
+    return 0;
+}
+
+
+/* AsyncioTransportType.tp_clear */
+static int
+AsyncioTransport_tp_clear(AsyncioTransport *self)
+{
+    Py_CLEAR(self->loop);
+    Py_CLEAR(self->sock);
+    Py_CLEAR(self->protocol);
+    Py_CLEAR(self->server);
+    Py_CLEAR(self->waiter);
+    Py_CLEAR(self->extra);
+    return 0;
+}
+
+
+/* AsyncioTransportType.tp_dealloc */
+static void
+AsyncioTransport_tp_dealloc(AsyncioTransport *self)
+{
+    PyObject_GC_UnTrack(self);
+    if (self->weakreflist) {
+        PyObject_ClearWeakRefs((PyObject *)self);
+    }
+    /* an active watcher holds a reference, both are stopped by now */
+    AsyncioTransport_ClearQueue(self);
+    PyMem_Free(self->queue);
+    AsyncioTransport_tp_clear(self);
+    Py_CLEAR(self->core);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+/* AsyncioTransportType.tp_repr */
+static PyObject *
+AsyncioTransport_tp_repr(AsyncioTransport *self)
+{
+    if (!self->sock) {
+        return PyUnicode_FromFormat("<%s closed fd=%d>",
+                                    Py_TYPE(self)->tp_name, self->fd);
+    }
+    return PyUnicode_FromFormat("<%s%s fd=%d bufsize=%zd>",
+                                Py_TYPE(self)->tp_name,
+                                self->closing ? " closing" : "",
+                                self->fd, self->queued);
+}
+
+
+/* Transport.write(data) */
+PyDoc_STRVAR(AsyncioTransport_write_doc,
+"write(data)");
+
+static PyObject *
+AsyncioTransport_write(AsyncioTransport *self, PyObject *data)
+{
+    Py_buffer view;
+    Py_ssize_t count;
+
+    if (AsyncioTransport_GetBuffer(data, &view)) {
+        return NULL;
+    }
+    if (self->eof) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Cannot call write() after write_eof()");
+        return NULL;
+    }
+    if (!view.len || self->conn_lost) {
+        if (view.len) {
+            self->conn_lost++;
+        }
+        PyBuffer_Release(&view);
+        Py_RETURN_NONE;
+    }
+    if (self->queue_head == self->queue_tail) {
+        /* try to send it right away */
+        do {
+            count = send(self->fd, view.buf, view.len, 0);
+        } while (count < 0 && errno == EINTR);
+        if (count < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                PyBuffer_Release(&view);
+                PyErr_SetFromErrno(PyExc_OSError);
+                if (AsyncioTransport_Fatal(self,
+                        "Fatal write error on socket transport")) {
+                    return NULL;
+                }
+                Py_RETURN_NONE;
+            }
+            count = 0;
+        }
+        if (count == view.len) {
+            PyBuffer_Release(&view);
+            Py_RETURN_NONE;
+        }
+        if (AsyncioTransport_Enqueue(self, &view, count)) {
+            return NULL;
+        }
+        AsyncioTransport_Watch(self, &self->writer, 1);
+    }
+    else if (AsyncioTransport_Enqueue(self, &view, 0)) {
+        return NULL;
+    }
+    if (AsyncioTransport_MaybePause(self)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.writelines(list_of_data) */
+PyDoc_STRVAR(AsyncioTransport_writelines_doc,
+"writelines(list_of_data)");
+
+static PyObject *
+AsyncioTransport_writelines(AsyncioTransport *self, PyObject *list_of_data)
+{
+    ev_io *writer = &self->writer;
+    PyObject *items;
+    Py_buffer view;
+    Py_ssize_t i;
+
+    if (self->eof) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Cannot call writelines() after write_eof()");
+        return NULL;
+    }
+    if (!(items = PySequence_Fast(list_of_data, "expected a sequence"))) {
+        return NULL;
+    }
+    for (i = 0; i < PySequence_Fast_GET_SIZE(items); i++) {
+        if (PyObject_GetBuffer(PySequence_Fast_GET_ITEM(items, i), &view,
+                               PyBUF_SIMPLE)) {
+            Py_DECREF(items);
+            return NULL;
+        }
+        if (!view.len || self->conn_lost) {
+            PyBuffer_Release(&view);
+        }
+        else if (AsyncioTransport_Enqueue(self, &view, 0)) {
+            Py_DECREF(items);
+            return NULL;
+        }
+    }
+    Py_DECREF(items);
+    /* one writev() for all of it, unless the writer is already waiting */
+    if (!self->conn_lost && !ev_is_active(writer) &&
+        AsyncioTransport_WriteReady(self)) {
+        return NULL;
+    }
+    if (AsyncioTransport_MaybePause(self)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.write_eof() */
+PyDoc_STRVAR(AsyncioTransport_write_eof_doc,
+"write_eof()");
+
+static PyObject *
+AsyncioTransport_write_eof(AsyncioTransport *self)
+{
+    if (self->closing || self->eof) {
+        Py_RETURN_NONE;
+    }
+    self->eof = 1;
+    if (self->queue_head == self->queue_tail && shutdown(self->fd, SHUT_WR)) {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.can_write_eof() -> bool */
+PyDoc_STRVAR(AsyncioTransport_can_write_eof_doc,
+"can_write_eof() -> bool");
+
+static PyObject *
+AsyncioTransport_can_write_eof(AsyncioTransport *self)
+{
+    Py_RETURN_TRUE;
+}
+
+
+/* Transport.get_write_buffer_size() -> int */
+PyDoc_STRVAR(AsyncioTransport_get_write_buffer_size_doc,
+"get_write_buffer_size() -> int");
+
+static PyObject *
+AsyncioTransport_get_write_buffer_size(AsyncioTransport *self)
+{
+    return PyLong_FromSsize_t(self->queued);
+}
+
+
+/* Transport.set_write_buffer_limits([high=None, low=None]) */
+PyDoc_STRVAR(AsyncioTransport_set_write_buffer_limits_doc,
+"set_write_buffer_limits([high=None, low=None])");
+
+static PyObject *
+AsyncioTransport_set_write_buffer_limits(AsyncioTransport *self,
+                                         PyObject *args, PyObject *kwargs)
+{
+    PyObject *high = NULL, *low = NULL;
+
+    static char *kwlist[] = {"high", "low", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
+                                     "|OO:set_write_buffer_limits", kwlist,
+                                     &high, &low)) {
+        return NULL;
+    }
+    if (AsyncioTransport_SetLimits(self, high, low) ||
+        AsyncioTransport_MaybePause(self)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.get_write_buffer_limits() -> (low, high) */
+PyDoc_STRVAR(AsyncioTransport_get_write_buffer_limits_doc,
+"get_write_buffer_limits() -> (low, high)");
+
+static PyObject *
+AsyncioTransport_get_write_buffer_limits(AsyncioTransport *self)
+{
+    return Py_BuildValue("(nn)", self->low, self->high);
+}
+
+
+/* Transport.is_reading() -> bool */
+PyDoc_STRVAR(AsyncioTransport_is_reading_doc,
+"is_reading() -> bool");
+
+static PyObject *
+AsyncioTransport_is_reading(AsyncioTransport *self)
+{
+    return PyBool_FromLong(!self->closing && !self->paused);
+}
+
+
+/* Transport.pause_reading() */
+PyDoc_STRVAR(AsyncioTransport_pause_reading_doc,
+"pause_reading()");
+
+static PyObject *
+AsyncioTransport_pause_reading(AsyncioTransport *self)
+{
+    if (!self->closing && !self->paused) {
+        self->paused = 1;
+        AsyncioTransport_Watch(self, &self->reader, 0);
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.resume_reading() */
+PyDoc_STRVAR(AsyncioTransport_resume_reading_doc,
+"resume_reading()");
+
+static PyObject *
+AsyncioTransport_resume_reading(AsyncioTransport *self)
+{
+    if (!self->closing && self->paused) {
+        self->paused = 0;
+        AsyncioTransport_Watch(self, &self->reader, 1);
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.is_closing() -> bool */
+PyDoc_STRVAR(AsyncioTransport_is_closing_doc,
+"is_closing() -> bool");
+
+static PyObject *
+AsyncioTransport_is_closing(AsyncioTransport *self)
+{
+    return PyBool_FromLong(self->closing);
+}
+
+
+/* Transport.close() */
+PyDoc_STRVAR(AsyncioTransport_close_doc,
+"close()");
+
+static PyObject *
+AsyncioTransport_close(AsyncioTransport *self)
+{
+    if (AsyncioTransport_Close(self)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.abort() */
+PyDoc_STRVAR(AsyncioTransport_abort_doc,
+"abort()");
+
+static PyObject *
+AsyncioTransport_abort(AsyncioTransport *self)
+{
+    if (AsyncioTransport_ForceClose(self, NULL)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.get_extra_info(name[, default=None]) -> object */
+PyDoc_STRVAR(AsyncioTransport_get_extra_info_doc,
+"get_extra_info(name[, default=None]) -> object");
+
+static PyObject *
+AsyncioTransport_get_extra_info(AsyncioTransport *self, PyObject *args,
+                                PyObject *kwargs)
+{
+    PyObject *name, *value = Py_None, *result = NULL;
+
+    static char *kwlist[] = {"name", "default", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:get_extra_info",
+                                     kwlist, &name, &value)) {
+        return NULL;
+    }
+    if (self->extra && !(result = PyDict_GetItemWithError(self->extra, name)) &&
+        PyErr_Occurred()) {
+        return NULL;
+    }
+    result = result ? result : value;
+    Py_INCREF(result);
+    return result;
+}
+
+
+/* Transport.set_protocol(protocol) */
+PyDoc_STRVAR(AsyncioTransport_set_protocol_doc,
+"set_protocol(protocol)");
+
+static PyObject *
+AsyncioTransport_set_protocol(AsyncioTransport *self, PyObject *protocol)
+{
+    if (AsyncioTransport_SetProtocol(self, protocol)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport.get_protocol() -> object */
+PyDoc_STRVAR(AsyncioTransport_get_protocol_doc,
+"get_protocol() -> object");
+
+static PyObject *
+AsyncioTransport_get_protocol(AsyncioTransport *self)
+{
+    PyObject *result = self->protocol ? self->protocol : Py_None;
+
+    Py_INCREF(result);
+    return result;
+}
+
+
+/* Transport._force_close(exc) */
+PyDoc_STRVAR(AsyncioTransport__force_close_doc,
+"_force_close(exc)");
+
+static PyObject *
+AsyncioTransport__force_close(AsyncioTransport *self, PyObject *exc)
+{
+    if (AsyncioTransport_ForceClose(self, exc == Py_None ? NULL : exc)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport._call_connection_lost(exc) */
+PyDoc_STRVAR(AsyncioTransport__call_connection_lost_doc,
+"_call_connection_lost(exc)");
+
+static PyObject *
+AsyncioTransport__call_connection_lost(AsyncioTransport *self,
+                                       PyObject *args)
+{
+    PyObject *exc = NULL;
+
+    if (!PyArg_ParseTuple(args, "|O:_call_connection_lost", &exc)) {
+        return NULL;
+    }
+    if (AsyncioTransport_ConnectionLost(self, exc == Py_None ? NULL : exc)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Transport._connected(), after protocol.connection_made() */
+PyDoc_STRVAR(AsyncioTransport__connected_doc,
+"_connected()");
+
+static PyObject *
+AsyncioTransport__connected(AsyncioTransport *self)
+{
+    PyObject *waiter = self->waiter, *result;
+    int cancelled;
+
+    if (!self->closing && !self->paused) {
+        AsyncioTransport_Watch(self, &self->reader, 1);
+    }
+    if (!waiter) {
+        Py_RETURN_NONE;
+    }
+    self->waiter = NULL;
+    /* futures._set_result_unless_cancelled(waiter, None) */
+    result = PyObject_CallMethod(waiter, "cancelled", NULL);
+    if (result) {
+        cancelled = PyObject_IsTrue(result);
+        Py_DECREF(result);
+        result = NULL;
+        if (!cancelled) {
+            result = PyObject_CallMethod(waiter, "set_result", "O", Py_None);
+        }
+        else if (cancelled > 0) {
+            Py_INCREF(Py_None);
+            result = Py_None;
+        }
+    }
+    Py_DECREF(waiter);
+    return result;
+}
+
+
+/* AsyncioTransportType.tp_methods */
+static PyMethodDef AsyncioTransport_tp_methods[] = {
+    {"write", (PyCFunction)AsyncioTransport_write,
+     METH_O, AsyncioTransport_write_doc},
+    {"writelines", (PyCFunction)AsyncioTransport_writelines,
+     METH_O, AsyncioTransport_writelines_doc},
+    {"write_eof", (PyCFunction)AsyncioTransport_write_eof,
+     METH_NOARGS, AsyncioTransport_write_eof_doc},
+    {"can_write_eof", (PyCFunction)AsyncioTransport_can_write_eof,
+     METH_NOARGS, AsyncioTransport_can_write_eof_doc},
+    {"get_write_buffer_size",
+     (PyCFunction)AsyncioTransport_get_write_buffer_size,
+     METH_NOARGS, AsyncioTransport_get_write_buffer_size_doc},
+    {"set_write_buffer_limits",
+     (PyCFunction)AsyncioTransport_set_write_buffer_limits,
+     METH_VARARGS | METH_KEYWORDS,
+     AsyncioTransport_set_write_buffer_limits_doc},
+    {"get_write_buffer_limits",
+     (PyCFunction)AsyncioTransport_get_write_buffer_limits,
+     METH_NOARGS, AsyncioTransport_get_write_buffer_limits_doc},
+    {"is_reading", (PyCFunction)AsyncioTransport_is_reading,
+     METH_NOARGS, AsyncioTransport_is_reading_doc},
+    {"pause_reading", (PyCFunction)AsyncioTransport_pause_reading,
+     METH_NOARGS, AsyncioTransport_pause_reading_doc},
+    {"resume_reading", (PyCFunction)AsyncioTransport_resume_reading,
+     METH_NOARGS, AsyncioTransport_resume_reading_doc},
+    {"is_closing", (PyCFunction)AsyncioTransport_is_closing,
+     METH_NOARGS, AsyncioTransport_is_closing_doc},
+    {"close", (PyCFunction)AsyncioTransport_close,
+     METH_NOARGS, AsyncioTransport_close_doc},
+    {"abort", (PyCFunction)AsyncioTransport_abort,
+     METH_NOARGS, AsyncioTransport_abort_doc},
+    {"get_extra_info", (PyCFunction)AsyncioTransport_get_extra_info,
+     METH_VARARGS | METH_KEYWORDS, AsyncioTransport_get_extra_info_doc},
+    {"set_protocol", (PyCFunction)AsyncioTransport_set_protocol,
+     METH_O, AsyncioTransport_set_protocol_doc},
+    {"get_protocol", (PyCFunction)AsyncioTransport_get_protocol,
+     METH_NOARGS, AsyncioTransport_get_protocol_doc},
+    {"_force_close", (PyCFunction)AsyncioTransport__force_close,
+     METH_O, AsyncioTransport__force_close_doc},
+    {"_call_connection_lost",
+     (PyCFunction)AsyncioTransport__call_connection_lost,
+     METH_VARARGS, AsyncioTransport__call_connection_lost_doc},
+    {"_connected", (PyCFunction)AsyncioTransport__connected,
+     METH_NOARGS, AsyncioTransport__connected_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* Transport._loop */
+static PyObject *
+AsyncioTransport__loop_get(AsyncioTransport *self, void *closure)
+{
+    PyObject *result = self->loop ? self->loop : Py_None;
+
+    Py_INCREF(result);
+    return result;
+}
+
+
+/* Transport._sock */
+static PyObject *
+AsyncioTransport__sock_get(AsyncioTransport *self, void *closure)
+{
+    PyObject *result = self->sock ? self->sock : Py_None;
+
+    Py_INCREF(result);
+    return result;
+}
+
+
+/* Transport._start_tls_compatible */
+static PyObject *
+AsyncioTransport__start_tls_compatible_get(AsyncioTransport *self,
+                                           void *closure)
+{
+    Py_RETURN_TRUE;
+}
+
+
+/* AsyncioTransportType.tp_getsets */
+static PyGetSetDef AsyncioTransport_tp_getsets[] = {
+    {"_loop", (getter)AsyncioTransport__loop_get,
+     Readonly_attribute_set, NULL, NULL},
+    {"_sock", (getter)AsyncioTransport__sock_get,
+     Readonly_attribute_set, NULL, NULL},
+    {"_start_tls_compatible",
+     (getter)AsyncioTransport__start_tls_compatible_get,
+     Readonly_attribute_set, NULL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* AsyncioTransportType.tp_members */
+static PyMemberDef AsyncioTransport_tp_members[] = {
+    {"_sock_fd", T_INT, offsetof(AsyncioTransport, fd), READONLY, NULL},
+    {"_paused", T_INT, offsetof(AsyncioTransport, paused), READONLY, NULL},
+    {"_protocol_paused", T_INT, offsetof(AsyncioTransport, protocol_paused),
+     READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* AsyncioTransportType */
+static PyTypeObject AsyncioTransportType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.asyncio.Transport",                 /*tp_name*/
+    sizeof(AsyncioTransport),                 /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)AsyncioTransport_tp_dealloc,  /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    (reprfunc)AsyncioTransport_tp_repr,       /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    AsyncioTransport_tp_doc,                  /*tp_doc*/
+    (traverseproc)AsyncioTransport_tp_traverse, /*tp_traverse*/
+    (inquiry)AsyncioTransport_tp_clear,       /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    offsetof(AsyncioTransport, weakreflist),  /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    AsyncioTransport_tp_methods,              /*tp_methods*/
+    AsyncioTransport_tp_members,              /*tp_members*/
+    AsyncioTransport_tp_getsets,              /*tp_getsets*/
+};
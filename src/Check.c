@@ -7,11 +7,15 @@ PyDoc_STRVAR(Check_tp_doc,
 "Check(loop, callback[, data=None, priority=0])");
 
 
+/* CheckType operations */
+PYEV_WATCHER_OPS(ev_check, EV_CHECK, 0);
+
+
 /* CheckType.tp_new */
 static PyObject *
 Check_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_CHECK, sizeof(ev_check));
+    return (PyObject *)Watcher_New(type, &ev_check_ops);
 }
 
 
@@ -19,7 +23,7 @@ Check_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject CheckType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Check",                             /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_check),     /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
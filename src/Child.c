@@ -133,11 +133,15 @@ Child_tp_init(Watcher *self, PyObject *args, PyObject *kwargs)
 }
 
 
+/* ChildType operations */
+PYEV_WATCHER_OPS(ev_child, EV_CHILD, 0);
+
+
 /* ChildType.tp_new */
 static PyObject *
 Child_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_CHILD, sizeof(ev_child));
+    return (PyObject *)Watcher_New(type, &ev_child_ops);
 }
 
 
@@ -145,7 +149,7 @@ Child_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject ChildType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Child",                             /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_child),     /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
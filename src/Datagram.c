@@ -0,0 +1,576 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_DATAGRAM_COUNT 32
+#define PYEV_DATAGRAM_SIZE 2048
+#define PYEV_DATAGRAM_SEND_MAX 64
+
+
+#ifndef MSG_WAITFORONE
+/* no recvmmsg()/sendmmsg(), emulate them with recvmsg()/sendmsg() */
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+static int
+recvmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags,
+         struct timespec *timeout)
+{
+    unsigned int i;
+    ssize_t result;
+
+    for (i = 0; i < vlen; i++) {
+        result = recvmsg(fd, &msgs[i].msg_hdr, flags);
+        if (result < 0) {
+            return i ? (int)i : -1;
+        }
+        msgs[i].msg_len = result;
+    }
+    return i;
+}
+
+static int
+sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags)
+{
+    unsigned int i;
+    ssize_t result;
+
+    for (i = 0; i < vlen; i++) {
+        result = sendmsg(fd, &msgs[i].msg_hdr, flags);
+        if (result < 0) {
+            return i ? (int)i : -1;
+        }
+        msgs[i].msg_len = result;
+    }
+    return i;
+}
+#endif
+
+
+/* convert a Python address to a socket address of the given family */
+int
+Sockaddr_FromPyObject(PyObject *pyaddr, int family,
+                      struct sockaddr_storage *addr, socklen_t *addrlen)
+{
+    const char *host;
+    Py_ssize_t length;
+    int port;
+    unsigned int flowinfo = 0, scope_id = 0;
+
+    memset(addr, 0, sizeof(struct sockaddr_storage));
+    switch (family) {
+        case AF_INET: {
+            struct sockaddr_in *in = (struct sockaddr_in *)addr;
+            if (!PyArg_ParseTuple(pyaddr, "si:address", &host, &port)) {
+                return -1;
+            }
+            if (inet_pton(AF_INET, host, &in->sin_addr) != 1) {
+                PyErr_Format(PyExc_ValueError,
+                             "'%s' is not a numeric IPv4 address", host);
+                return -1;
+            }
+            in->sin_family = AF_INET;
+            in->sin_port = htons((unsigned short)port);
+            *addrlen = sizeof(struct sockaddr_in);
+            return 0;
+        }
+        case AF_INET6: {
+            struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)addr;
+            if (!PyArg_ParseTuple(pyaddr, "si|II:address", &host, &port,
+                                  &flowinfo, &scope_id)) {
+                return -1;
+            }
+            if (inet_pton(AF_INET6, host, &in6->sin6_addr) != 1) {
+                PyErr_Format(PyExc_ValueError,
+                             "'%s' is not a numeric IPv6 address", host);
+                return -1;
+            }
+            in6->sin6_family = AF_INET6;
+            in6->sin6_port = htons((unsigned short)port);
+            in6->sin6_flowinfo = htonl(flowinfo);
+            in6->sin6_scope_id = scope_id;
+            *addrlen = sizeof(struct sockaddr_in6);
+            return 0;
+        }
+        case AF_UNIX: {
+            struct sockaddr_un *un = (struct sockaddr_un *)addr;
+            if (!PyArg_Parse(pyaddr, "s#:address", &host, &length)) {
+                return -1;
+            }
+            if (length >= (Py_ssize_t)sizeof(un->sun_path)) {
+                PyErr_SetString(PyExc_ValueError, "AF_UNIX path too long");
+                return -1;
+            }
+            un->sun_family = AF_UNIX;
+            memcpy(un->sun_path, host, length);
+            *addrlen = offsetof(struct sockaddr_un, sun_path) + length;
+            if (length && host[0]) {
+                /* not in the abstract namespace, count the terminating NUL */
+                (*addrlen)++;
+            }
+            return 0;
+        }
+        default:
+            PyErr_SetString(Error, "unsupported address family");
+            return -1;
+    }
+}
+
+
+/* get a pool nobody else is looking at */
+int
+Datagram_Reserve(Datagram *self)
+{
+    PyObject *pool;
+
+    /* the views handed out reference the pool, if they are all gone it can be
+       reused, otherwise it is left to them and a new one is allocated */
+    if (self->pool && Py_REFCNT(self->pool) == 1) {
+        return 0;
+    }
+    pool = PyByteArray_FromStringAndSize(NULL, self->count * self->size);
+    if (!pool) {
+        return -1;
+    }
+    Py_XDECREF(self->pool);
+    self->pool = pool;
+    return 0;
+}
+
+
+/* (re)allocate the message headers */
+int
+Datagram_Alloc(Datagram *self, Py_ssize_t count, Py_ssize_t size)
+{
+    struct mmsghdr *msgs;
+    struct iovec *iov;
+    struct sockaddr_storage *addrs;
+
+    if (count <= 0 || count > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "'count' must be positive");
+        return -1;
+    }
+    if (size <= 0 || size > PY_SSIZE_T_MAX / count) {
+        PyErr_SetString(PyExc_ValueError, "invalid 'size'");
+        return -1;
+    }
+    msgs = PyMem_Malloc(count * sizeof(struct mmsghdr));
+    iov = PyMem_Malloc(count * sizeof(struct iovec));
+    addrs = PyMem_Malloc(count * sizeof(struct sockaddr_storage));
+    if (!msgs || !iov || !addrs) {
+        PyMem_Free(msgs);
+        PyMem_Free(iov);
+        PyMem_Free(addrs);
+        PyErr_NoMemory();
+        return -1;
+    }
+    PyMem_Free(self->msgs);
+    PyMem_Free(self->iov);
+    PyMem_Free(self->addrs);
+    self->msgs = msgs;
+    self->iov = iov;
+    self->addrs = addrs;
+    Py_CLEAR(self->pool);
+    self->count = count;
+    self->size = size;
+    return 0;
+}
+
+
+/* receive up to self->count datagrams, returns -1 on error */
+int
+Datagram_Receive(Datagram *self)
+{
+    int fd = ((ev_io *)((Watcher *)self)->watcher)->fd;
+    char *data = PyByteArray_AS_STRING(self->pool);
+    Py_ssize_t i;
+    int result;
+
+    for (i = 0; i < self->count; i++) {
+        self->iov[i].iov_base = data + i * self->size;
+        self->iov[i].iov_len = self->size;
+        memset(&self->msgs[i].msg_hdr, 0, sizeof(struct msghdr));
+        self->msgs[i].msg_hdr.msg_name = &self->addrs[i];
+        self->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        self->msgs[i].msg_hdr.msg_iov = &self->iov[i];
+        self->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    do {
+        result = recvmmsg(fd, self->msgs, (unsigned int)self->count,
+                          MSG_DONTWAIT, NULL);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        self->error = errno;
+    }
+    return result;
+}
+
+
+/* build the list of (memoryview, address, truncated) tuples */
+PyObject *
+Datagram_Batch(Datagram *self, int count)
+{
+    PyObject *batch, *base, *view, *pyaddr, *truncated, *item;
+    Py_ssize_t offset;
+    int i;
+
+    batch = PyList_New(count);
+    if (!batch) {
+        return NULL;
+    }
+    base = PyMemoryView_FromObject(self->pool);
+    if (!base) {
+        Py_DECREF(batch);
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        offset = i * self->size;
+        view = PySequence_GetSlice(base, offset,
+                                   offset + self->msgs[i].msg_len);
+        if (!view) {
+            goto fail;
+        }
+        pyaddr = Sockaddr_AsPyObject((struct sockaddr *)&self->addrs[i],
+                                     self->msgs[i].msg_hdr.msg_namelen);
+        if (!pyaddr) {
+            Py_DECREF(view);
+            goto fail;
+        }
+        /* the datagram was longer than self->size, the rest is lost */
+        truncated = PyBool_FromLong(self->msgs[i].msg_hdr.msg_flags & MSG_TRUNC);
+        item = PyTuple_New(3);
+        if (!item) {
+            Py_DECREF(truncated);
+            Py_DECREF(pyaddr);
+            Py_DECREF(view);
+            goto fail;
+        }
+        PyTuple_SET_ITEM(item, 0, view);
+        PyTuple_SET_ITEM(item, 1, pyaddr);
+        PyTuple_SET_ITEM(item, 2, truncated);
+        PyList_SET_ITEM(batch, i, item);
+    }
+    Py_DECREF(base);
+    return batch;
+
+fail:
+    Py_DECREF(base);
+    Py_DECREF(batch);
+    return NULL;
+}
+
+
+/* call the Python callback with a batch (or None) */
+void
+Datagram_Invoke(Datagram *self, struct ev_loop *loop, PyObject *batch)
+{
+    PyObject *pyresult =
+        Callback_Invoke(((Watcher *)self)->callback, (PyObject *)self, batch);
+    if (!pyresult) {
+        Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+}
+
+
+/* datagram io callback */
+static void
+Datagram_Callback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    Datagram *self = io->data;
+    PyObject *batch;
+    int result;
+
+    if (revents & EV_ERROR) {
+        Watcher_Callback(loop, (ev_watcher *)io, revents);
+        return;
+    }
+    if (Datagram_Reserve(self)) {
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    result = Datagram_Receive(self);
+    if (!result) {
+        return;
+    }
+    Py_INCREF(self);
+    if (result < 0) {
+        Datagram_Invoke(self, loop, Py_None);
+    }
+    else {
+        batch = Datagram_Batch(self, result);
+        if (!batch) {
+            PYEV_LOOP_EXIT(loop);
+        }
+        else {
+            Datagram_Invoke(self, loop, batch);
+            Py_DECREF(batch);
+        }
+    }
+    Py_DECREF(self);
+}
+
+
+/* set the Datagram */
+int
+Datagram_Set(Datagram *self, PyObject *fd)
+{
+    struct sockaddr_storage addr;
+    socklen_t addrlen = sizeof(addr);
+
+    if (Io_Set((Watcher *)self, fd, EV_READ)) {
+        return -1;
+    }
+    if (getsockname(((ev_io *)((Watcher *)self)->watcher)->fd,
+                    (struct sockaddr *)&addr, &addrlen)) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+    }
+    self->family = addr.ss_family;
+    self->error = 0;
+    return 0;
+}
+
+
+/*******************************************************************************
+* DatagramType
+*******************************************************************************/
+
+/* DatagramType.tp_doc */
+PyDoc_STRVAR(Datagram_tp_doc,
+"Datagram(fd, loop, callback[, data=None, priority=0, count=32, size=2048])");
+
+
+/* DatagramType.tp_dealloc */
+static void
+Datagram_tp_dealloc(Datagram *self)
+{
+    Py_CLEAR(self->pool);
+    PyMem_Free(self->msgs);
+    PyMem_Free(self->iov);
+    PyMem_Free(self->addrs);
+    self->msgs = NULL;
+    self->iov = NULL;
+    self->addrs = NULL;
+    IoType.tp_dealloc((PyObject *)self);
+}
+
+
+/* Datagram.set(fd) */
+PyDoc_STRVAR(Datagram_set_doc,
+"set(fd)");
+
+static PyObject *
+Datagram_set(Datagram *self, PyObject *args)
+{
+    PyObject *fd;
+
+    PYEV_WATCHER_SET((Watcher *)self);
+    if (!PyArg_ParseTuple(args, "O:set", &fd)) {
+        return NULL;
+    }
+    if (Datagram_Set(self, fd)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Datagram.send_many(datagrams) -> int */
+PyDoc_STRVAR(Datagram_send_many_doc,
+"send_many(datagrams) -> int");
+
+static PyObject *
+Datagram_send_many(Datagram *self, PyObject *args)
+{
+    int fd = ((ev_io *)((Watcher *)self)->watcher)->fd;
+    struct mmsghdr msgs[PYEV_DATAGRAM_SEND_MAX];
+    struct iovec iov[PYEV_DATAGRAM_SEND_MAX];
+    struct sockaddr_storage addrs[PYEV_DATAGRAM_SEND_MAX];
+    Py_buffer views[PYEV_DATAGRAM_SEND_MAX];
+    PyObject *datagrams, *pydatagrams, *item, *pydata, *pyaddr;
+    Py_ssize_t count, sent = 0;
+    int j, chunk = 0, result;
+
+    if (!PyArg_ParseTuple(args, "O:send_many", &datagrams)) {
+        return NULL;
+    }
+    pydatagrams = PySequence_Fast(datagrams, "'datagrams' must be a sequence");
+    if (!pydatagrams) {
+        return NULL;
+    }
+    count = PySequence_Fast_GET_SIZE(pydatagrams);
+    while (sent < count) {
+        /* fill a chunk */
+        for (chunk = 0;
+             chunk < PYEV_DATAGRAM_SEND_MAX && sent + chunk < count;
+             chunk++) {
+            item = PySequence_Fast_GET_ITEM(pydatagrams, sent + chunk);
+            pyaddr = Py_None;
+            if (PyTuple_Check(item)) {
+                if (!PyArg_ParseTuple(item, "OO:send_many", &pydata, &pyaddr)) {
+                    goto fail;
+                }
+            }
+            else {
+                pydata = item;
+            }
+            memset(&msgs[chunk].msg_hdr, 0, sizeof(struct msghdr));
+            if (pyaddr != Py_None) {
+                if (Sockaddr_FromPyObject(pyaddr, self->family, &addrs[chunk],
+                                          &msgs[chunk].msg_hdr.msg_namelen)) {
+                    goto fail;
+                }
+                msgs[chunk].msg_hdr.msg_name = &addrs[chunk];
+            }
+            if (PyObject_GetBuffer(pydata, &views[chunk], PyBUF_SIMPLE)) {
+                goto fail;
+            }
+            iov[chunk].iov_base = views[chunk].buf;
+            iov[chunk].iov_len = views[chunk].len;
+            msgs[chunk].msg_hdr.msg_iov = &iov[chunk];
+            msgs[chunk].msg_hdr.msg_iovlen = 1;
+        }
+        do {
+            result = sendmmsg(fd, msgs, chunk, MSG_DONTWAIT);
+        } while (result < 0 && errno == EINTR);
+        for (j = 0; j < chunk; j++) {
+            PyBuffer_Release(&views[j]);
+        }
+        chunk = 0;
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (!sent) {
+                PyErr_SetFromErrno(PyExc_OSError);
+                goto fail;
+            }
+            break;
+        }
+        sent += result;
+        if (result < PYEV_DATAGRAM_SEND_MAX && sent < count) {
+            /* short write, the socket buffer is full */
+            break;
+        }
+    }
+    Py_DECREF(pydatagrams);
+    return PyInt_FromSsize_t(sent);
+
+fail:
+    for (j = 0; j < chunk; j++) {
+        PyBuffer_Release(&views[j]);
+    }
+    Py_DECREF(pydatagrams);
+    return NULL;
+}
+
+
+/* DatagramType.tp_methods */
+static PyMethodDef Datagram_tp_methods[] = {
+    {"set", (PyCFunction)Datagram_set,
+     METH_VARARGS, Datagram_set_doc},
+    {"send_many", (PyCFunction)Datagram_send_many,
+     METH_VARARGS, Datagram_send_many_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* DatagramType.tp_members */
+static PyMemberDef Datagram_tp_members[] = {
+    {"count", T_PYSSIZET, offsetof(Datagram, count), READONLY, NULL},
+    {"size", T_PYSSIZET, offsetof(Datagram, size), READONLY, NULL},
+    {"error", T_INT, offsetof(Datagram, error), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* DatagramType.tp_init */
+static int
+Datagram_tp_init(Datagram *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *fd;
+    Loop *loop;
+    PyObject *callback, *data = NULL;
+    int priority = 0;
+    Py_ssize_t count = PYEV_DATAGRAM_COUNT, size = PYEV_DATAGRAM_SIZE;
+
+    static char *kwlist[] = {"fd",
+                             "loop", "callback", "data", "priority",
+                             "count", "size", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO!O|Oinn:__init__", kwlist,
+            &fd,
+            &LoopType, &loop, &callback, &data, &priority,
+            &count, &size)) {
+        return -1;
+    }
+    if (Watcher_Init((Watcher *)self, loop, callback, data, priority) ||
+        Datagram_Alloc(self, count, size)) {
+        return -1;
+    }
+    return Datagram_Set(self, fd);
+}
+
+
+/* DatagramType.tp_new */
+static PyObject *
+Datagram_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Datagram *self = (Datagram *)IoType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    ev_set_cb((ev_io *)((Watcher *)self)->watcher, Datagram_Callback);
+    return (PyObject *)self;
+}
+
+
+/* DatagramType */
+static PyTypeObject DatagramType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.Datagram",                          /*tp_name*/
+    PYEV_WATCHER_SIZE(Datagram, ev_io),       /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)Datagram_tp_dealloc,          /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    Datagram_tp_doc,                          /*tp_doc*/
+    0,                                        /*tp_traverse*/
+    0,                                        /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    Datagram_tp_methods,                      /*tp_methods*/
+    Datagram_tp_members,                      /*tp_members*/
+    0,                                        /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    (initproc)Datagram_tp_init,               /*tp_init*/
+    0,                                        /*tp_alloc*/
+    Datagram_tp_new,                          /*tp_new*/
+};
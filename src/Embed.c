@@ -129,11 +129,15 @@ Embed_tp_init(Embed *self, PyObject *args, PyObject *kwargs)
 }
 
 
+/* EmbedType operations */
+PYEV_WATCHER_OPS(ev_embed, EV_EMBED, 1);
+
+
 /* EmbedType.tp_new */
 static PyObject *
 Embed_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_EMBED, sizeof(ev_embed));
+    return (PyObject *)Watcher_New(type, &ev_embed_ops);
 }
 
 
@@ -141,7 +145,7 @@ Embed_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject EmbedType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Embed",                             /*tp_name*/
-    sizeof(Embed),                            /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Embed, ev_embed),       /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     (destructor)Embed_tp_dealloc,             /*tp_dealloc*/
     0,                                        /*tp_print*/
@@ -0,0 +1,173 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_EVENTBATCH_SIZE 64
+
+
+EventBatch *
+EventBatch_New(void)
+{
+    return (EventBatch *)EventBatchType.tp_alloc(&EventBatchType, 0);
+}
+
+
+/* append (watcher, revents), returns -1 (and sets an exception) on failure */
+int
+EventBatch_Append(EventBatch *self, PyObject *watcher, int revents)
+{
+    Py_ssize_t size;
+    PyObject **watchers;
+    int *events;
+
+    if (self->len == self->size) {
+        size = self->size ? self->size * 2 : PYEV_EVENTBATCH_SIZE;
+        watchers = PyMem_Realloc(self->watchers, size * sizeof(PyObject *));
+        if (!watchers) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->watchers = watchers;
+        events = PyMem_Realloc(self->revents, size * sizeof(int));
+        if (!events) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->revents = events;
+        self->size = size;
+    }
+    Py_INCREF(watcher);
+    self->watchers[self->len] = watcher;
+    self->revents[self->len] = revents;
+    self->len++;
+    return 0;
+}
+
+
+/* drop the watchers, but keep the arrays around for the next iteration */
+void
+EventBatch_Clear(EventBatch *self)
+{
+    Py_ssize_t len = self->len;
+
+    self->len = 0;
+    while (len--) {
+        Py_DECREF(self->watchers[len]);
+    }
+}
+
+
+/*******************************************************************************
+* EventBatchType
+*******************************************************************************/
+
+/* EventBatchType.tp_doc */
+PyDoc_STRVAR(EventBatch_tp_doc,
+"EventBatch: sequence of (watcher, revents)");
+
+
+/* EventBatchType.tp_traverse */
+static int
+EventBatch_tp_traverse(EventBatch *self, visitproc visit, void *arg)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < self->len; i++) {
+        Py_VISIT(self->watchers[i]);
+    }
+    return 0;
+}
+
+
+/* EventBatchType.tp_clear */
+static int
+EventBatch_tp_clear(EventBatch *self)
+{
+    EventBatch_Clear(self);
+    return 0;
+}
+
+
+/* EventBatchType.tp_dealloc */
+static void
+EventBatch_tp_dealloc(EventBatch *self)
+{
+    PyObject_GC_UnTrack(self);
+    EventBatch_tp_clear(self);
+    PyMem_Free(self->watchers);
+    PyMem_Free(self->revents);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+/* EventBatchType.tp_as_sequence.sq_length */
+static Py_ssize_t
+EventBatch_sq_length(EventBatch *self)
+{
+    return self->len;
+}
+
+
+/* EventBatchType.tp_as_sequence.sq_item */
+static PyObject *
+EventBatch_sq_item(EventBatch *self, Py_ssize_t i)
+{
+    if (i < 0 || i >= self->len) {
+        PyErr_SetString(PyExc_IndexError, "index out of range");
+        return NULL;
+    }
+    return Py_BuildValue("(ON)", self->watchers[i],
+                         Revents_FromInt(self->revents[i]));
+}
+
+
+/* EventBatchType.tp_as_sequence */
+static PySequenceMethods EventBatch_tp_as_sequence = {
+    (lenfunc)EventBatch_sq_length,            /*sq_length*/
+    0,                                        /*sq_concat*/
+    0,                                        /*sq_repeat*/
+    (ssizeargfunc)EventBatch_sq_item,         /*sq_item*/
+};
+
+
+/* EventBatchType */
+static PyTypeObject EventBatchType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.EventBatch",                        /*tp_name*/
+    sizeof(EventBatch),                       /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)EventBatch_tp_dealloc,        /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    &EventBatch_tp_as_sequence,               /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    EventBatch_tp_doc,                        /*tp_doc*/
+    (traverseproc)EventBatch_tp_traverse,     /*tp_traverse*/
+    (inquiry)EventBatch_tp_clear,             /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    0,                                        /*tp_methods*/
+    0,                                        /*tp_members*/
+    0,                                        /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    0,                                        /*tp_init*/
+    0,                                        /*tp_alloc*/
+    0,                                        /*tp_new*/
+};
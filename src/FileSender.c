@@ -0,0 +1,340 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_FILESENDER_CHUNK 65536
+/* Linux never transfers more than this in one call */
+#define PYEV_FILESENDER_MAX 0x7ffff000
+
+
+/* send a chunk with pread()/write(), for when sendfile() is not an option */
+Py_ssize_t
+FileSender_Copy(FileSender *self, int fd, size_t count)
+{
+    Py_ssize_t result;
+
+    if (!self->buffer) {
+        self->buffer = PyMem_Malloc(PYEV_FILESENDER_CHUNK);
+        if (!self->buffer) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    if (count > PYEV_FILESENDER_CHUNK) {
+        count = PYEV_FILESENDER_CHUNK;
+    }
+    result = pread(self->file, self->buffer, count, self->offset);
+    if (result <= 0) {
+        return result;
+    }
+    /* whatever the fd doesn't accept is simply read again next time */
+    result = write(fd, self->buffer, result);
+    if (result > 0) {
+        self->offset += result;
+    }
+    return result;
+}
+
+
+/* send a chunk, returns 0 on end of file and -1 on error (errno is set) */
+Py_ssize_t
+FileSender_Send(FileSender *self, int fd)
+{
+    size_t count = PYEV_FILESENDER_MAX;
+    Py_ssize_t result;
+
+    if (self->remaining >= 0 && (PY_LONG_LONG)count > self->remaining) {
+        count = (size_t)self->remaining;
+    }
+    if (!count) {
+        return 0;
+    }
+#ifdef __linux__
+    if (!self->copy) {
+        result = sendfile(fd, self->file, &self->offset, count);
+        if (result >= 0 || (errno != EINVAL && errno != ENOSYS)) {
+            return result;
+        }
+        /* the file can't be mmap'ed (or similar) */
+        self->copy = 1;
+    }
+#endif
+    return FileSender_Copy(self, fd, count);
+}
+
+
+/* call the Python callback with the number of bytes sent (or None) */
+void
+FileSender_Invoke(FileSender *self, struct ev_loop *loop, PyObject *sent)
+{
+    PyObject *pyresult;
+
+    if (!sent) {
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    Py_INCREF(self);
+    pyresult = Callback_Invoke(((Watcher *)self)->callback,
+                               (PyObject *)self, sent);
+    if (!pyresult) {
+        Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+    Py_DECREF(sent);
+    Py_DECREF(self);
+}
+
+
+/* filesender io callback */
+static void
+FileSender_Callback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    FileSender *self = io->data;
+    Py_ssize_t result;
+
+    if (revents & EV_ERROR) {
+        Watcher_Callback(loop, (ev_watcher *)io, revents);
+        return;
+    }
+    for (;;) {
+        result = FileSender_Send(self, io->fd);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                /* wait for the next EV_WRITE */
+                return;
+            }
+            self->error = errno;
+            ev_io_stop(loop, io);
+            Py_INCREF(Py_None);
+            FileSender_Invoke(self, loop, Py_None);
+            return;
+        }
+        if (!result) {
+            break;
+        }
+        self->sent += result;
+        if (self->remaining > 0) {
+            self->remaining -= result;
+        }
+    }
+    ev_io_stop(loop, io);
+    FileSender_Invoke(self, loop, PyLong_FromUnsignedLongLong(self->sent));
+}
+
+
+/* set the FileSender */
+int
+FileSender_Set(FileSender *self, PyObject *fd, PyObject *file,
+               PY_LONG_LONG offset, PyObject *count)
+{
+    PY_LONG_LONG remaining = -1;
+    int filenum;
+
+    if (offset < 0) {
+        PyErr_SetString(PyExc_ValueError, "'offset' must be positive or 0");
+        return -1;
+    }
+    if (count != Py_None) {
+        remaining = PyLong_AsLongLong(count);
+        if (remaining == -1 && PyErr_Occurred()) {
+            return -1;
+        }
+        if (remaining < 0) {
+            PyErr_SetString(PyExc_ValueError,
+                            "'count' must be positive, 0 or None");
+            return -1;
+        }
+    }
+    filenum = PyObject_AsFileDescriptor(file);
+    if (filenum < 0) {
+        return -1;
+    }
+    if (Io_Set((Watcher *)self, fd, EV_WRITE)) {
+        return -1;
+    }
+    self->file = filenum;
+    self->offset = (off_t)offset;
+    self->remaining = remaining;
+    self->sent = 0;
+    self->copy = 0;
+    self->error = 0;
+    return 0;
+}
+
+
+/*******************************************************************************
+* FileSenderType
+*******************************************************************************/
+
+/* FileSenderType.tp_doc */
+PyDoc_STRVAR(FileSender_tp_doc,
+"FileSender(fd, file, loop, callback[, data=None, priority=0, offset=0,\n\
+           count=None])");
+
+
+/* FileSenderType.tp_dealloc */
+static void
+FileSender_tp_dealloc(FileSender *self)
+{
+    PyMem_Free(self->buffer);
+    self->buffer = NULL;
+    IoType.tp_dealloc((PyObject *)self);
+}
+
+
+/* FileSender.set(fd, file[, offset=0, count=None]) */
+PyDoc_STRVAR(FileSender_set_doc,
+"set(fd, file[, offset=0, count=None])");
+
+static PyObject *
+FileSender_set(FileSender *self, PyObject *args)
+{
+    PyObject *fd, *file, *count = Py_None;
+    PY_LONG_LONG offset = 0;
+
+    PYEV_WATCHER_SET((Watcher *)self);
+    if (!PyArg_ParseTuple(args, "OO|LO:set", &fd, &file, &offset, &count)) {
+        return NULL;
+    }
+    if (FileSender_Set(self, fd, file, offset, count)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* FileSenderType.tp_methods */
+static PyMethodDef FileSender_tp_methods[] = {
+    {"set", (PyCFunction)FileSender_set,
+     METH_VARARGS, FileSender_set_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* FileSenderType.tp_members */
+static PyMemberDef FileSender_tp_members[] = {
+    {"file", T_INT, offsetof(FileSender, file), READONLY, NULL},
+    {"sent", T_ULONGLONG, offsetof(FileSender, sent), READONLY, NULL},
+    {"error", T_INT, offsetof(FileSender, error), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* FileSender.offset */
+static PyObject *
+FileSender_offset_get(FileSender *self, void *closure)
+{
+    return PyLong_FromLongLong((PY_LONG_LONG)self->offset);
+}
+
+
+/* FileSender.remaining */
+static PyObject *
+FileSender_remaining_get(FileSender *self, void *closure)
+{
+    if (self->remaining < 0) {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromLongLong(self->remaining);
+}
+
+
+/* FileSenderType.tp_getsets */
+static PyGetSetDef FileSender_tp_getsets[] = {
+    {"offset", (getter)FileSender_offset_get,
+     Readonly_attribute_set, NULL, NULL},
+    {"remaining", (getter)FileSender_remaining_get,
+     Readonly_attribute_set, NULL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* FileSenderType.tp_init */
+static int
+FileSender_tp_init(FileSender *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *fd, *file;
+    Loop *loop;
+    PyObject *callback, *data = NULL;
+    int priority = 0;
+    PY_LONG_LONG offset = 0;
+    PyObject *count = Py_None;
+
+    static char *kwlist[] = {"fd", "file",
+                             "loop", "callback", "data", "priority",
+                             "offset", "count", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO!O|OiLO:__init__", kwlist,
+            &fd, &file,
+            &LoopType, &loop, &callback, &data, &priority,
+            &offset, &count)) {
+        return -1;
+    }
+    if (Watcher_Init((Watcher *)self, loop, callback, data, priority)) {
+        return -1;
+    }
+    return FileSender_Set(self, fd, file, offset, count);
+}
+
+
+/* FileSenderType.tp_new */
+static PyObject *
+FileSender_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    FileSender *self = (FileSender *)IoType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    ev_set_cb((ev_io *)((Watcher *)self)->watcher, FileSender_Callback);
+    self->file = -1;
+    self->remaining = -1;
+    return (PyObject *)self;
+}
+
+
+/* FileSenderType */
+static PyTypeObject FileSenderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.FileSender",                        /*tp_name*/
+    PYEV_WATCHER_SIZE(FileSender, ev_io),     /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)FileSender_tp_dealloc,        /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    FileSender_tp_doc,                        /*tp_doc*/
+    0,                                        /*tp_traverse*/
+    0,                                        /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    FileSender_tp_methods,                    /*tp_methods*/
+    FileSender_tp_members,                    /*tp_members*/
+    FileSender_tp_getsets,                    /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    (initproc)FileSender_tp_init,             /*tp_init*/
+    0,                                        /*tp_alloc*/
+    FileSender_tp_new,                        /*tp_new*/
+};
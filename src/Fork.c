@@ -7,11 +7,15 @@ PyDoc_STRVAR(Fork_tp_doc,
 "Fork(loop, callback[, data=None, priority=0])");
 
 
+/* ForkType operations */
+PYEV_WATCHER_OPS(ev_fork, EV_FORK, 0);
+
+
 /* ForkType.tp_new */
 static PyObject *
 Fork_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_FORK, sizeof(ev_fork));
+    return (PyObject *)Watcher_New(type, &ev_fork_ops);
 }
 
 
@@ -19,7 +23,7 @@ Fork_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject ForkType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Fork",                              /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_fork),      /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
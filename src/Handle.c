@@ -0,0 +1,177 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+/* create a handle for callback(*args) */
+Handle *
+Handle_New(Loop *loop, PyObject *callback, PyObject *args)
+{
+    Handle *self = PyObject_GC_New(Handle, &HandleType);
+    if (!self) {
+        return NULL;
+    }
+    Py_INCREF(loop);
+    self->loop = loop;
+    Py_INCREF(callback);
+    self->callback = callback;
+    Py_INCREF(args);
+    self->args = args;
+    self->when = 0.0;
+    self->seq = 0;
+    self->index = -1;
+    self->cancelled = 0;
+    PyObject_GC_Track(self);
+    return self;
+}
+
+
+/* run the callback, unless cancelled, errors are reported like watcher
+   callback errors */
+void
+Handle_Run(Handle *self)
+{
+    PyObject *callback = self->callback, *pyresult;
+
+    if (self->cancelled) {
+        return;
+    }
+    Py_INCREF(callback);
+    pyresult = PyObject_Call(callback, self->args, NULL);
+    if (!pyresult) {
+        Loop_WarnOrStop(self->loop, callback);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+    Py_DECREF(callback);
+}
+
+
+/*******************************************************************************
+* HandleType
+*******************************************************************************/
+
+/* HandleType.tp_doc */
+PyDoc_STRVAR(Handle_tp_doc,
+"Handle");
+
+
+/* HandleType.tp_traverse */
+static int
+Handle_tp_traverse(Handle *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->loop);
+    Py_VISIT(self->callback);
+    Py_VISIT(self->args);
+    return 0;
+}
+
+
+/* HandleType.tp_clear */
+static int
+Handle_tp_clear(Handle *self)
+{
+    Py_CLEAR(self->callback);
+    Py_CLEAR(self->args);
+    Py_CLEAR(self->loop);
+    return 0;
+}
+
+
+/* HandleType.tp_dealloc */
+static void
+Handle_tp_dealloc(Handle *self)
+{
+    PyObject_GC_UnTrack(self);
+    Handle_tp_clear(self);
+    PyObject_GC_Del(self);
+}
+
+
+/* Handle.cancel() */
+PyDoc_STRVAR(Handle_cancel_doc,
+"cancel()");
+
+static PyObject *
+Handle_cancel(Handle *self)
+{
+    if (!self->cancelled) {
+        self->cancelled = 1;
+        if (self->index >= 0) {
+            Loop_CancelLater(self->loop, self);
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Handle.cancelled() -> bool */
+PyDoc_STRVAR(Handle_cancelled_doc,
+"cancelled() -> bool");
+
+static PyObject *
+Handle_cancelled(Handle *self)
+{
+    return PyBool_FromLong(self->cancelled);
+}
+
+
+/* HandleType.tp_methods */
+static PyMethodDef Handle_tp_methods[] = {
+    {"cancel", (PyCFunction)Handle_cancel,
+     METH_NOARGS, Handle_cancel_doc},
+    {"cancelled", (PyCFunction)Handle_cancelled,
+     METH_NOARGS, Handle_cancelled_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* HandleType.tp_members */
+static PyMemberDef Handle_tp_members[] = {
+    {"loop", T_OBJECT_EX, offsetof(Handle, loop), READONLY, NULL},
+    {"callback", T_OBJECT_EX, offsetof(Handle, callback), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* HandleType */
+static PyTypeObject HandleType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.Handle",                            /*tp_name*/
+    sizeof(Handle),                           /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)Handle_tp_dealloc,            /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    Handle_tp_doc,                            /*tp_doc*/
+    (traverseproc)Handle_tp_traverse,         /*tp_traverse*/
+    (inquiry)Handle_tp_clear,                 /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    Handle_tp_methods,                        /*tp_methods*/
+    Handle_tp_members,                        /*tp_members*/
+    0,                                        /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    0,                                        /*tp_init*/
+    0,                                        /*tp_alloc*/
+    0,                                        /*tp_new*/
+};
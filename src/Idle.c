@@ -7,11 +7,15 @@ PyDoc_STRVAR(Idle_tp_doc,
 "Idle(loop, callback[, data=None, priority=0])");
 
 
+/* IdleType operations */
+PYEV_WATCHER_OPS(ev_idle, EV_IDLE, 0);
+
+
 /* IdleType.tp_new */
 static PyObject *
 Idle_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_IDLE, sizeof(ev_idle));
+    return (PyObject *)Watcher_New(type, &ev_idle_ops);
 }
 
 
@@ -19,7 +23,7 @@ Idle_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject IdleType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Idle",                              /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_idle),      /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
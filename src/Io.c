@@ -2,6 +2,32 @@
 * utilities
 *******************************************************************************/
 
+/* check the event mask */
+int
+Io_CheckEvents(int events)
+{
+    if (events & ~(EV_READ | EV_WRITE)) {
+        PyErr_SetString(Error, "illegal event mask");
+        return -1;
+    }
+    return 0;
+}
+
+
+/* Stream, Acceptor, Datagram, Relay and FileSender drive their own events,
+   changing them from the outside would stall or spin them */
+int
+Io_CheckModify(Watcher *self)
+{
+    if (ev_cb(self->watcher) != Watcher_Callback) {
+        PyErr_Format(PyExc_TypeError, "can't modify the events of a '%.200s'",
+                     Py_TYPE(self)->tp_name);
+        return -1;
+    }
+    return 0;
+}
+
+
 /* set the Io */
 int
 Io_Set(Watcher *self, PyObject *fd, int events)
@@ -10,8 +36,7 @@ Io_Set(Watcher *self, PyObject *fd, int events)
     if (fdnum < 0) {
         return -1;
     }
-    if (events & ~(EV_READ | EV_WRITE)) {
-        PyErr_SetString(Error, "illegal event mask");
+    if (Io_CheckEvents(events)) {
         return -1;
     }
     ev_io_set((ev_io *)self->watcher, fdnum, events);
@@ -19,6 +44,38 @@ Io_Set(Watcher *self, PyObject *fd, int events)
 }
 
 
+/* change the events of the Io, even if it is active.
+   an active Io is stopped and restarted, which only queues an fd change in
+   libev: the backend is updated once, before the next poll, however many times
+   the events are changed in between. A pending event is kept, masked by the
+   new events */
+void
+Io_Modify(Watcher *self, int events)
+{
+    ev_io *io = (ev_io *)self->watcher;
+    struct ev_loop *loop;
+    int revents;
+
+    PYEV_BEGIN_LOCK(self->loop);
+    if ((io->events & (EV_READ | EV_WRITE)) != events) {
+        if (ev_is_active(io)) {
+            loop = self->loop->loop;
+            revents = ev_clear_pending(loop, io);
+            ev_io_stop(loop, io);
+            PYEV_IO_MODIFY(io, events);
+            ev_io_start(loop, io);
+            if (revents & events) {
+                ev_feed_event(loop, io, revents & events);
+            }
+        }
+        else {
+            PYEV_IO_MODIFY(io, events);
+        }
+    }
+    PYEV_END_LOCK();
+}
+
+
 /*******************************************************************************
 * IoType
 *******************************************************************************/
@@ -49,10 +106,32 @@ Io_set(Watcher *self, PyObject *args)
 }
 
 
+/* Io.modify(events) */
+PyDoc_STRVAR(Io_modify_doc,
+"modify(events)");
+
+static PyObject *
+Io_modify(Watcher *self, PyObject *args)
+{
+    int events;
+
+    if (!PyArg_ParseTuple(args, "i:modify", &events)) {
+        return NULL;
+    }
+    if (Io_CheckModify(self) || Io_CheckEvents(events)) {
+        return NULL;
+    }
+    Io_Modify(self, events);
+    Py_RETURN_NONE;
+}
+
+
 /* IoType.tp_methods */
 static PyMethodDef Io_tp_methods[] = {
     {"set", (PyCFunction)Io_set,
      METH_VARARGS, Io_set_doc},
+    {"modify", (PyCFunction)Io_modify,
+     METH_VARARGS, Io_modify_doc},
     {NULL}  /* Sentinel */
 };
 
@@ -69,7 +148,8 @@ Io_fd_get(Watcher *self, void *closure)
 static PyObject *
 Io_events_get(Watcher *self, void *closure)
 {
-    return PyInt_FromLong(((ev_io *)self->watcher)->events);
+    return PyInt_FromLong(
+        ((ev_io *)self->watcher)->events & (EV_READ | EV_WRITE));
 }
 
 
@@ -108,11 +188,15 @@ Io_tp_init(Watcher *self, PyObject *args, PyObject *kwargs)
 }
 
 
+/* IoType operations */
+PYEV_WATCHER_OPS(ev_io, EV_IO, 0);
+
+
 /* IoType.tp_new */
 static PyObject *
 Io_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_IO, sizeof(ev_io));
+    return (PyObject *)Watcher_New(type, &ev_io_ops);
 }
 
 
@@ -120,7 +204,7 @@ Io_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject IoType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Io",                                /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_io),        /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
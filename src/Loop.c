@@ -15,11 +15,384 @@ Loop_WarnOrStop(Loop *self, PyObject *context)
 }
 
 
+/* invoke pending watchers, handing their events to self->batch if set */
+void
+Loop_Invoke(Loop *self)
+{
+    EventBatch *events;
+    PyObject *pyresult;
+
+    if (!self->batch || self->batch == Py_None || self->batching) {
+        ev_invoke_pending(self->loop);
+        return;
+    }
+    if (!self->events && !(self->events = EventBatch_New())) {
+        PYEV_LOOP_EXIT(self->loop);
+        return;
+    }
+    self->batching = 1;
+    ev_invoke_pending(self->loop);
+    self->batching = 0;
+    events = self->events;
+    if (PyErr_Occurred()) {
+        EventBatch_Clear(events);
+        return;
+    }
+    if (!events->len) {
+        return;
+    }
+    /* a nested invoke gets a batch of its own */
+    self->events = NULL;
+    pyresult = Callback_Invoke(self->batch, (PyObject *)self,
+                               (PyObject *)events);
+    if (!pyresult) {
+        PYEV_LOOP_EXIT(self->loop);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+    if (Py_REFCNT(events) == 1 && !self->events) {
+        /* nobody kept it, reuse it next iteration */
+        EventBatch_Clear(events);
+        self->events = events;
+    }
+    else {
+        Py_DECREF(events);
+    }
+}
+
+
+#if EV_IDLE_ENABLE
+/* busy poll idle callback, back to blocking polls once the window is over */
+static void
+Loop_BusyCallback(struct ev_loop *loop, ev_idle *idle, int revents)
+{
+    Loop *self = ev_userdata(loop);
+    if (ev_now(loop) >= self->busy_until) {
+        ev_ref(loop);
+        ev_idle_stop(loop, idle);
+    }
+}
+#endif
+
+
+/* events arrived, poll without blocking (and without releasing the GIL) for
+   self->busy_poll seconds. The idle watcher has the lowest priority, it is
+   only pending when nothing else is */
+static void
+Loop_BusyPoll(Loop *self)
+{
+#if EV_IDLE_ENABLE
+    ev_idle *idle = &self->busy;
+    if (ev_pending_count(self->loop) && !ev_is_pending(idle)) {
+        self->busy_until = ev_now(self->loop) + self->busy_poll;
+        if (!ev_is_active(idle)) {
+            ev_idle_start(self->loop, idle);
+            /* it must not keep the loop alive */
+            ev_unref(self->loop);
+        }
+    }
+#endif
+}
+
+
+#define PYEV_SOON_SIZE 64
+#define PYEV_LATER_SIZE 64
+
+
+#ifdef PYEV_READY_ENABLE
+/* run the callbacks queued by call_soon() */
+static void
+Loop_RunSoon(Loop *self)
+{
+    Py_ssize_t n = self->soon_len;
+    Handle *handle;
+
+    /* the ones they queue run on the next iteration */
+    while (n-- && !PyErr_Occurred()) {
+        handle = self->soon[self->soon_head];
+        self->soon_head = (self->soon_head + 1) & (self->soon_size - 1);
+        self->soon_len--;
+        Handle_Run(handle);
+        Py_DECREF(handle);
+    }
+}
+
+
+/* run the tasks that were ready when we started, the ones they make ready
+   run on the next iteration */
+static void
+Loop_RunTasks(Loop *self)
+{
+    Task *task, *last = self->ready_last;
+    int stop = 0;
+
+    while (!stop && (task = self->ready_first) && !PyErr_Occurred()) {
+        if (!(self->ready_first = task->next)) {
+            self->ready_last = NULL;
+        }
+        task->next = NULL;
+        stop = (task == last);
+        Task_Run(task);
+    }
+}
+
+
+/* ready check callback, runs the ready queue once per iteration */
+static void
+Loop_ReadyCallback(struct ev_loop *loop, ev_check *check, int revents)
+{
+    Loop *self = ev_userdata(loop);
+
+    /* a callback dropping the last reference to the loop would free us */
+    Py_INCREF(self);
+    Loop_RunSoon(self);
+    Loop_RunTasks(self);
+    if (!self->soon_len && !self->ready_first) {
+        ev_idle *idle = &self->ready_idle;
+        ev_idle_stop(loop, idle);
+        ev_check_stop(loop, check);
+    }
+    Py_DECREF(self);
+}
+
+
+/* ready idle callback, it only keeps the loop from blocking */
+static void
+Loop_ReadyIdle(struct ev_loop *loop, ev_idle *idle, int revents)
+{
+}
+#endif
+
+
+/* make sure the ready queue runs on the next iteration */
+int
+Loop_Ready(Loop *self)
+{
+#ifdef PYEV_READY_ENABLE
+    ev_check *check = &self->ready_check;
+    ev_idle *idle = &self->ready_idle;
+
+    if (!ev_is_active(check)) {
+        ev_check_start(self->loop, check);
+        ev_idle_start(self->loop, idle);
+    }
+    return 0;
+#else
+    PyErr_SetString(Error,
+                    "the ready queue needs Check and Idle watchers support");
+    return -1;
+#endif
+}
+
+
+/* queue a task, it will run from the ready queue */
+int
+Loop_Schedule(Loop *self, Task *task)
+{
+    int result;
+
+    PYEV_BEGIN_LOCK(self);
+    if (!(result = Loop_Ready(self))) {
+        Py_INCREF(task);
+        if (self->ready_last) {
+            self->ready_last->next = task;
+        }
+        else {
+            self->ready_first = task;
+        }
+        self->ready_last = task;
+    }
+    PYEV_END_LOCK();
+    return result;
+}
+
+
+/* queue a handle, it will run from the ready queue */
+int
+Loop_CallSoon(Loop *self, Handle *handle)
+{
+    Handle **soon;
+    Py_ssize_t size, i;
+    int result = -1;
+
+    PYEV_BEGIN_LOCK(self);
+    if (self->soon_len == self->soon_size) {
+        /* grow (the size stays a power of 2) and unwrap the ring */
+        size = self->soon_size ? self->soon_size * 2 : PYEV_SOON_SIZE;
+        if ((soon = PyMem_New(Handle *, size))) {
+            for (i = 0; i < self->soon_len; i++) {
+                soon[i] = self->soon[(self->soon_head + i) &
+                                     (self->soon_size - 1)];
+            }
+            PyMem_Free(self->soon);
+            self->soon = soon;
+            self->soon_size = size;
+            self->soon_head = 0;
+        }
+        else {
+            PyErr_NoMemory();
+        }
+    }
+    if (self->soon_len < self->soon_size && !Loop_Ready(self)) {
+        Py_INCREF(handle);
+        self->soon[(self->soon_head + self->soon_len) &
+                   (self->soon_size - 1)] = handle;
+        self->soon_len++;
+        result = 0;
+    }
+    PYEV_END_LOCK();
+    return result;
+}
+
+
+/* call_later() heap, ordered by time then by call */
+#define PYEV_LATER_LT(a, b) \
+    ((a)->when < (b)->when || ((a)->when == (b)->when && (a)->seq < (b)->seq))
+
+
+/* move the handle at i up or down to its place in the heap */
+static void
+Loop_LaterSift(Loop *self, Py_ssize_t i)
+{
+    Handle **later = self->later, *handle = later[i];
+    Py_ssize_t parent, child;
+
+    while (i > 0 && PYEV_LATER_LT(handle, later[(parent = (i - 1) / 2)])) {
+        later[i] = later[parent];
+        later[i]->index = i;
+        i = parent;
+    }
+    while ((child = 2 * i + 1) < self->later_len) {
+        if (child + 1 < self->later_len &&
+            PYEV_LATER_LT(later[child + 1], later[child])) {
+            child++;
+        }
+        if (!PYEV_LATER_LT(later[child], handle)) {
+            break;
+        }
+        later[i] = later[child];
+        later[i]->index = i;
+        i = child;
+    }
+    later[i] = handle;
+    handle->index = i;
+}
+
+
+/* take the handle at i out of the heap, we get its reference */
+static Handle *
+Loop_LaterRemove(Loop *self, Py_ssize_t i)
+{
+    Handle *handle = self->later[i];
+
+    handle->index = -1;
+    if (i != --self->later_len) {
+        self->later[i] = self->later[self->later_len];
+        Loop_LaterSift(self, i);
+    }
+    return handle;
+}
+
+
+/* (re)start the timer for the first handle of the heap */
+static void
+Loop_LaterArm(Loop *self)
+{
+    ev_timer *timer = &self->later_timer;
+    double after;
+
+    ev_timer_stop(self->loop, timer);
+    if (self->later_len) {
+        after = self->later[0]->when - ev_now(self->loop);
+        ev_timer_set(timer, after > 0.0 ? after : 0.0, 0.0);
+        ev_timer_start(self->loop, timer);
+    }
+}
+
+
+/* later timer callback, runs the handles that are due (but not the ones
+   they add) */
+static void
+Loop_LaterCallback(struct ev_loop *loop, ev_timer *timer, int revents)
+{
+    Loop *self = ev_userdata(loop);
+    unsigned long seq = self->later_seq;
+    ev_tstamp now = ev_now(loop);
+    Handle *handle;
+
+    /* a callback dropping the last reference to the loop would free us */
+    Py_INCREF(self);
+    while (self->later_len && !PyErr_Occurred() &&
+           self->later[0]->when <= now && self->later[0]->seq < seq) {
+        handle = Loop_LaterRemove(self, 0);
+        Handle_Run(handle);
+        Py_DECREF(handle);
+    }
+    Loop_LaterArm(self);
+    Py_DECREF(self);
+}
+
+
+/* add a handle to the heap, it will run in delay seconds */
+int
+Loop_CallLater(Loop *self, Handle *handle, double delay)
+{
+    Handle **later;
+    Py_ssize_t size;
+    int result = -1;
+
+    PYEV_BEGIN_LOCK(self);
+    if (self->later_len == self->later_size) {
+        size = self->later_size ? self->later_size * 2 : PYEV_LATER_SIZE;
+        if ((later = PyMem_Realloc(self->later, size * sizeof(Handle *)))) {
+            self->later = later;
+            self->later_size = size;
+        }
+        else {
+            PyErr_NoMemory();
+        }
+    }
+    if (self->later_len < self->later_size) {
+        handle->when = ev_now(self->loop) + (delay > 0.0 ? delay : 0.0);
+        handle->seq = self->later_seq++;
+        Py_INCREF(handle);
+        self->later[self->later_len++] = handle;
+        Loop_LaterSift(self, self->later_len - 1);
+        if (!handle->index) {
+            Loop_LaterArm(self);
+        }
+        result = 0;
+    }
+    PYEV_END_LOCK();
+    return result;
+}
+
+
+/* take a cancelled handle out of the heap */
+void
+Loop_CancelLater(Loop *self, Handle *handle)
+{
+    Py_ssize_t index = handle->index;
+
+    PYEV_BEGIN_LOCK(self);
+    Loop_LaterRemove(self, index);
+    if (!index) {
+        Loop_LaterArm(self);
+    }
+    PYEV_END_LOCK();
+    Py_DECREF(handle);
+}
+
+
 /* loop pending callback */
 static void
 Loop_InvokePending(struct ev_loop *loop)
 {
     Loop *self = ev_userdata(loop);
+    if (self->busy_poll) {
+        Loop_BusyPoll(self);
+    }
     if (self->callback && self->callback != Py_None) {
         PyObject *result =
             PyObject_CallFunctionObjArgs(self->callback, self, NULL);
@@ -31,7 +404,7 @@ Loop_InvokePending(struct ev_loop *loop)
         }
     }
     else {
-        ev_invoke_pending(loop);
+        Loop_Invoke(self);
     }
 }
 
@@ -40,6 +413,16 @@ static void
 Loop_Release(struct ev_loop *loop)
 {
     Loop *self = ev_userdata(loop);
+#if EV_IDLE_ENABLE
+    ev_idle *idle = &self->busy;
+    if (ev_is_active(idle)) {
+        /* the poll won't block, keep the GIL */
+        self->spins++;
+        self->spinning = 1;
+        return;
+    }
+#endif
+    self->sleeps++;
     self->tstate = PyEval_SaveThread();
 }
 
@@ -47,6 +430,10 @@ static void
 Loop_Acquire(struct ev_loop *loop)
 {
     Loop *self = ev_userdata(loop);
+    if (self->spinning) {
+        self->spinning = 0;
+        return;
+    }
     PyEval_RestoreThread(self->tstate);
 }
 
@@ -58,7 +445,24 @@ Loop_SetCallback(Loop *self, PyObject *callback)
     PYEV_CHECK_CALLABLE_OR_NONE(callback);
     PyObject *tmp = self->callback;
     Py_INCREF(callback);
+    PYEV_BEGIN_LOCK(self);
     self->callback = callback;
+    PYEV_END_LOCK();
+    Py_XDECREF(tmp);
+    return 0;
+}
+
+
+/* set batch callable */
+int
+Loop_SetBatch(Loop *self, PyObject *batch)
+{
+    PYEV_CHECK_CALLABLE_OR_NONE(batch);
+    PyObject *tmp = self->batch;
+    Py_INCREF(batch);
+    PYEV_BEGIN_LOCK(self);
+    self->batch = batch;
+    PYEV_END_LOCK();
     Py_XDECREF(tmp);
     return 0;
 }
@@ -81,26 +485,48 @@ Loop_SetInterval(Loop *self, double interval, int io)
 }
 
 
+/* set busy poll window */
+int
+Loop_SetBusyPoll(Loop *self, double busy_poll)
+{
+    PYEV_CHECK_POSITIVE_OR_ZERO_FLOAT(busy_poll);
+#if EV_IDLE_ENABLE
+    ev_idle *idle = &self->busy;
+    if (!busy_poll && ev_is_active(idle)) {
+        ev_ref(self->loop);
+        ev_idle_stop(self->loop, idle);
+    }
+#else
+    if (busy_poll) {
+        PyErr_SetString(Error, "busy polling needs Idle watchers support");
+        return -1;
+    }
+#endif
+    self->busy_poll = busy_poll;
+    return 0;
+}
+
+
 /* instanciate a Loop */
 Loop *
 Loop_New(PyTypeObject *type, PyObject *args, PyObject *kwargs, int default_loop)
 {
     unsigned int flags = EVFLAG_AUTO;
     PyObject *callback = NULL, *data = NULL;
-    double io_interval = 0.0, timeout_interval = 0.0;
+    double io_interval = 0.0, timeout_interval = 0.0, busy_poll = 0.0;
     int debug = 0;
 
     static char *kwlist[] = {"flags",
                              "callback", "data",
                              "io_interval", "timeout_interval",
-                             "debug",
+                             "debug", "busy_poll",
                              NULL};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|IOOddO&:__new__", kwlist,
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|IOOddO&d:__new__", kwlist,
                                      &flags,
                                      &callback, &data,
                                      &io_interval, &timeout_interval,
-                                     Boolean_Predicate, &debug)) {
+                                     Boolean_Predicate, &debug, &busy_poll)) {
         return NULL;
     }
 
@@ -134,6 +560,30 @@ Loop_New(PyTypeObject *type, PyObject *args, PyObject *kwargs, int default_loop)
     }
     /* self->debug */
     self->debug = debug;
+    /* self->busy and self->busy_poll */
+#if EV_IDLE_ENABLE
+    ev_idle *idle = &self->busy;
+    ev_idle_init(idle, Loop_BusyCallback);
+    ev_set_priority(idle, EV_MINPRI);
+#endif
+    if (Loop_SetBusyPoll(self, busy_poll)) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    /* self->ready_check and self->ready_idle */
+#ifdef PYEV_READY_ENABLE
+    ev_check *ready_check = &self->ready_check;
+    ev_check_init(ready_check, Loop_ReadyCallback);
+    ev_idle *ready_idle = &self->ready_idle;
+    ev_idle_init(ready_idle, Loop_ReadyIdle);
+    ev_set_priority(ready_idle, EV_MINPRI);
+#endif
+    /* self->later_timer, the heap is allocated on first use */
+    ev_timer *later_timer = &self->later_timer;
+    ev_timer_init(later_timer, Loop_LaterCallback, 0.0, 0.0);
+    /* self->pool is created on first use */
+    self->pool_size = PYEV_POOL_SIZE;
+    self->pool_maxsize = PYEV_POOL_MAXSIZE;
     /* done */
     ev_set_userdata(self->loop, self);
     ev_set_invoke_pending_cb(self->loop, Loop_InvokePending);
@@ -149,15 +599,29 @@ Loop_New(PyTypeObject *type, PyObject *args, PyObject *kwargs, int default_loop)
 /* LoopType.tp_doc */
 PyDoc_STRVAR(Loop_tp_doc,
 "Loop([flags=EVFLAG_AUTO, callback=None, data=None,\n\
-       io_interval=0.0, timeout_interval=0.0, debug=False])");
+       io_interval=0.0, timeout_interval=0.0, debug=False, busy_poll=0.0])");
 
 
 /* LoopType.tp_traverse */
 static int
 Loop_tp_traverse(Loop *self, visitproc visit, void *arg)
 {
+    Task *task;
+    Py_ssize_t i;
+
     Py_VISIT(self->data);
     Py_VISIT(self->callback);
+    Py_VISIT(self->batch);
+    Py_VISIT(self->events);
+    for (task = self->ready_first; task; task = task->next) {
+        Py_VISIT(task);
+    }
+    for (i = 0; i < self->soon_len; i++) {
+        Py_VISIT(self->soon[(self->soon_head + i) & (self->soon_size - 1)]);
+    }
+    for (i = 0; i < self->later_len; i++) {
+        Py_VISIT(self->later[i]);
+    }
     return 0;
 }
 
@@ -166,8 +630,34 @@ Loop_tp_traverse(Loop *self, visitproc visit, void *arg)
 static int
 Loop_tp_clear(Loop *self)
 {
+    Task *task;
+    Handle *handle;
+
     Py_CLEAR(self->data);
     Py_CLEAR(self->callback);
+    Py_CLEAR(self->batch);
+    Py_CLEAR(self->events);
+    while ((task = self->ready_first)) {
+        if (!(self->ready_first = task->next)) {
+            self->ready_last = NULL;
+        }
+        task->next = NULL;
+        Py_DECREF(task);
+    }
+    while (self->soon_len) {
+        handle = self->soon[self->soon_head];
+        self->soon_head = (self->soon_head + 1) & (self->soon_size - 1);
+        self->soon_len--;
+        Py_DECREF(handle);
+    }
+    if (self->later_len) {
+        ev_timer *timer = &self->later_timer;
+        ev_timer_stop(self->loop, timer);
+        while (self->later_len) {
+            handle = Loop_LaterRemove(self, self->later_len - 1);
+            Py_DECREF(handle);
+        }
+    }
     return 0;
 }
 
@@ -177,7 +667,13 @@ static void
 Loop_tp_dealloc(Loop *self)
 {
     printf("Loop_tp_dealloc\n");
+    if (self->pool) {
+        Pool_Destroy(self->pool);
+        self->pool = NULL;
+    }
     Loop_tp_clear(self);
+    PyMem_Free(self->soon);
+    PyMem_Free(self->later);
     if (self->loop) {
         PYEV_LOOP_EXIT(self->loop);
         if (ev_is_default_loop(self->loop)) {
@@ -271,7 +767,12 @@ PyDoc_STRVAR(Loop_invoke_doc,
 static PyObject *
 Loop_invoke(Loop *self)
 {
-    ev_invoke_pending(self->loop);
+    PYEV_BEGIN_LOCK(self);
+    Loop_Invoke(self);
+    PYEV_END_LOCK();
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
     Py_RETURN_NONE;
 }
 
@@ -283,7 +784,9 @@ PyDoc_STRVAR(Loop_verify_doc,
 static PyObject *
 Loop_verify(Loop *self)
 {
+    PYEV_BEGIN_LOCK(self);
     ev_verify(self->loop);
+    PYEV_END_LOCK();
     Py_RETURN_NONE;
 }
 
@@ -300,7 +803,11 @@ Loop_start(Loop *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "|i:start", &flags)) {
         return NULL;
     }
-    int result = ev_run(self->loop, flags);
+    int result;
+
+    PYEV_BEGIN_LOCK(self);
+    result = ev_run(self->loop, flags);
+    PYEV_END_LOCK();
     if (PyErr_Occurred()) {
         return NULL;
     }
@@ -320,11 +827,206 @@ Loop_stop(Loop *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "|i:stop", &how)) {
         return NULL;
     }
+    PYEV_BEGIN_LOCK(self);
     ev_break(self->loop, how);
+    PYEV_END_LOCK();
     Py_RETURN_NONE;
 }
 
 
+/* Loop.set_pool(size[, maxsize]) */
+PyDoc_STRVAR(Loop_set_pool_doc,
+"set_pool(size[, maxsize])");
+
+static PyObject *
+Loop_set_pool(Loop *self, PyObject *args)
+{
+    int size;
+    Py_ssize_t maxsize = PYEV_POOL_MAXSIZE;
+
+    if (!PyArg_ParseTuple(args, "i|n:set_pool", &size, &maxsize)) {
+        return NULL;
+    }
+    if (self->pool) {
+        PyErr_SetString(Error, "pool already started");
+        return NULL;
+    }
+    if (size < 1 || maxsize < 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "'size' and 'maxsize' must be greater than 0");
+        return NULL;
+    }
+    self->pool_size = size;
+    self->pool_maxsize = maxsize;
+    Py_RETURN_NONE;
+}
+
+
+/* Loop.run_in_pool(callable, *args, callback) */
+PyDoc_STRVAR(Loop_run_in_pool_doc,
+"run_in_pool(callable, *args, callback)");
+
+static PyObject *
+Loop_run_in_pool(Loop *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *callable, *callback = NULL, *pyargs;
+    int result;
+
+    if (kwargs) {
+        callback = PyDict_GetItemString(kwargs, "callback");
+    }
+    if (!callback || PyDict_Size(kwargs) != 1) {
+        PyErr_SetString(PyExc_TypeError,
+                        "run_in_pool() takes exactly one keyword argument "
+                        "('callback')");
+        return NULL;
+    }
+    if (PyTuple_GET_SIZE(args) < 1) {
+        PyErr_SetString(PyExc_TypeError,
+                        "run_in_pool() takes at least 1 positional argument");
+        return NULL;
+    }
+    callable = PyTuple_GET_ITEM(args, 0);
+    if (!PyCallable_Check(callable) || !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+    if (!self->pool &&
+        !(self->pool = Pool_New(self->loop, self->pool_size,
+                                self->pool_maxsize))) {
+        return NULL;
+    }
+    pyargs = PyTuple_GetSlice(args, 1, PyTuple_GET_SIZE(args));
+    if (!pyargs) {
+        return NULL;
+    }
+    result = Pool_Submit(self->pool, callable, pyargs, callback);
+    Py_DECREF(pyargs);
+    if (result) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Loop.call_soon(callback, *args) -> Handle */
+PyDoc_STRVAR(Loop_call_soon_doc,
+"call_soon(callback, *args) -> Handle");
+
+static PyObject *
+Loop_call_soon(Loop *self, PyObject *args)
+{
+    PyObject *callback, *pyargs;
+    Handle *handle;
+
+    if (PyTuple_GET_SIZE(args) < 1) {
+        PyErr_SetString(PyExc_TypeError,
+                        "call_soon() takes at least 1 argument");
+        return NULL;
+    }
+    callback = PyTuple_GET_ITEM(args, 0);
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+    if (!(pyargs = PyTuple_GetSlice(args, 1, PyTuple_GET_SIZE(args)))) {
+        return NULL;
+    }
+    handle = Handle_New(self, callback, pyargs);
+    Py_DECREF(pyargs);
+    if (handle && Loop_CallSoon(self, handle)) {
+        Py_CLEAR(handle);
+    }
+    return (PyObject *)handle;
+}
+
+
+/* Loop.call_later(delay, callback, *args) -> Handle */
+PyDoc_STRVAR(Loop_call_later_doc,
+"call_later(delay, callback, *args) -> Handle");
+
+static PyObject *
+Loop_call_later(Loop *self, PyObject *args)
+{
+    PyObject *callback, *pyargs;
+    Handle *handle;
+    double delay;
+
+    if (PyTuple_GET_SIZE(args) < 2) {
+        PyErr_SetString(PyExc_TypeError,
+                        "call_later() takes at least 2 arguments");
+        return NULL;
+    }
+    delay = PyFloat_AsDouble(PyTuple_GET_ITEM(args, 0));
+    if (delay == -1.0 && PyErr_Occurred()) {
+        return NULL;
+    }
+    callback = PyTuple_GET_ITEM(args, 1);
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+    if (!(pyargs = PyTuple_GetSlice(args, 2, PyTuple_GET_SIZE(args)))) {
+        return NULL;
+    }
+    handle = Handle_New(self, callback, pyargs);
+    Py_DECREF(pyargs);
+    if (handle && Loop_CallLater(self, handle, delay)) {
+        Py_CLEAR(handle);
+    }
+    return (PyObject *)handle;
+}
+
+
+/* Loop.wait_readable(fd) -> Wait */
+PyDoc_STRVAR(Loop_wait_readable_doc,
+"wait_readable(fd) -> Wait");
+
+static PyObject *
+Loop_wait_readable(Loop *self, PyObject *fd)
+{
+    return Wait_NewIo(self, fd, EV_READ);
+}
+
+
+/* Loop.wait_writable(fd) -> Wait */
+PyDoc_STRVAR(Loop_wait_writable_doc,
+"wait_writable(fd) -> Wait");
+
+static PyObject *
+Loop_wait_writable(Loop *self, PyObject *fd)
+{
+    return Wait_NewIo(self, fd, EV_WRITE);
+}
+
+
+/* Loop.sleep(seconds) -> Wait */
+PyDoc_STRVAR(Loop_sleep_doc,
+"sleep(seconds) -> Wait");
+
+static PyObject *
+Loop_sleep(Loop *self, PyObject *args)
+{
+    double seconds;
+
+    if (!PyArg_ParseTuple(args, "d:sleep", &seconds)) {
+        return NULL;
+    }
+    return Wait_NewTimer(self, seconds);
+}
+
+
+/* Loop.spawn(coro) -> Task */
+PyDoc_STRVAR(Loop_spawn_doc,
+"spawn(coro) -> Task");
+
+static PyObject *
+Loop_spawn(Loop *self, PyObject *coro)
+{
+    return Task_New(self, coro);
+}
+
+
 /* watcher methods */
 
 PyObject *
@@ -363,6 +1065,188 @@ Loop_io(Loop *self, PyObject *args)
 }
 
 
+/* Loop.io_modify_many(watchers, events) */
+PyDoc_STRVAR(Loop_io_modify_many_doc,
+"io_modify_many(watchers, events)");
+
+static PyObject *
+Loop_io_modify_many(Loop *self, PyObject *args)
+{
+    PyObject *watchers, *events, *item;
+    PyObject *pywatchers = NULL, *pyevents = NULL;
+    Py_ssize_t i, count;
+    int mask = 0;
+
+    if (!PyArg_ParseTuple(args, "OO:io_modify_many", &watchers, &events)) {
+        return NULL;
+    }
+    pywatchers = PySequence_Fast(watchers, "'watchers' must be a sequence");
+    if (!pywatchers) {
+        return NULL;
+    }
+    count = PySequence_Fast_GET_SIZE(pywatchers);
+    if (PyNumber_Check(events)) {
+        mask = PyInt_AsLong(events);
+        if ((mask == -1 && PyErr_Occurred()) || Io_CheckEvents(mask)) {
+            goto fail;
+        }
+    }
+    else {
+        pyevents = PySequence_Fast(events,
+                                   "'events' must be an int or a sequence");
+        if (!pyevents) {
+            goto fail;
+        }
+        if (PySequence_Fast_GET_SIZE(pyevents) != count) {
+            PyErr_SetString(PyExc_ValueError,
+                            "'watchers' and 'events' must have the same length");
+            goto fail;
+        }
+    }
+    /* validate everything first, so that we don't stop half way */
+    for (i = 0; i < count; i++) {
+        item = PySequence_Fast_GET_ITEM(pywatchers, i);
+        if (!PyObject_TypeCheck(item, &IoType)) {
+            PyErr_SetString(PyExc_TypeError, "'watchers' must only contain "
+                            "pyev.Io objects");
+            goto fail;
+        }
+        if (Io_CheckModify((Watcher *)item)) {
+            goto fail;
+        }
+        if (((Watcher *)item)->loop != self) {
+            PyErr_SetString(Error, "watcher belongs to another loop");
+            goto fail;
+        }
+        if (pyevents) {
+            mask = PyInt_AsLong(PySequence_Fast_GET_ITEM(pyevents, i));
+            if ((mask == -1 && PyErr_Occurred()) || Io_CheckEvents(mask)) {
+                goto fail;
+            }
+        }
+    }
+    for (i = 0; i < count; i++) {
+        if (pyevents) {
+            mask = PyInt_AsLong(PySequence_Fast_GET_ITEM(pyevents, i));
+        }
+        Io_Modify((Watcher *)PySequence_Fast_GET_ITEM(pywatchers, i), mask);
+    }
+    Py_XDECREF(pyevents);
+    Py_DECREF(pywatchers);
+    Py_RETURN_NONE;
+
+fail:
+    Py_XDECREF(pyevents);
+    Py_DECREF(pywatchers);
+    return NULL;
+}
+
+
+/* Loop.stream(fd, callback[, data, priority]) -> pyev.Stream */
+PyDoc_STRVAR(Loop_stream_doc,
+"stream(fd, callback[, data, priority]) -> pyev.Stream");
+
+static PyObject *
+Loop_stream(Loop *self, PyObject *args)
+{
+    PyObject *fd;
+    PyObject *callback, *data = Py_None, *priority = NULL;
+
+    if (!PyArg_UnpackTuple(args, "stream", 2, 4,
+                           &fd,
+                           &callback, &data, &priority)) {
+        return NULL;
+    }
+    return PyObject_CallFunctionObjArgs((PyObject *)&StreamType,
+                                        fd,
+                                        self, callback, data, priority, NULL);
+}
+
+
+/* Loop.acceptor(fd, callback[, data, priority]) -> pyev.Acceptor */
+PyDoc_STRVAR(Loop_acceptor_doc,
+"acceptor(fd, callback[, data, priority]) -> pyev.Acceptor");
+
+static PyObject *
+Loop_acceptor(Loop *self, PyObject *args)
+{
+    PyObject *fd;
+    PyObject *callback, *data = Py_None, *priority = NULL;
+
+    if (!PyArg_UnpackTuple(args, "acceptor", 2, 4,
+                           &fd,
+                           &callback, &data, &priority)) {
+        return NULL;
+    }
+    return PyObject_CallFunctionObjArgs((PyObject *)&AcceptorType,
+                                        fd,
+                                        self, callback, data, priority, NULL);
+}
+
+
+/* Loop.datagram(fd, callback[, data, priority]) -> pyev.Datagram */
+PyDoc_STRVAR(Loop_datagram_doc,
+"datagram(fd, callback[, data, priority]) -> pyev.Datagram");
+
+static PyObject *
+Loop_datagram(Loop *self, PyObject *args)
+{
+    PyObject *fd;
+    PyObject *callback, *data = Py_None, *priority = NULL;
+
+    if (!PyArg_UnpackTuple(args, "datagram", 2, 4,
+                           &fd,
+                           &callback, &data, &priority)) {
+        return NULL;
+    }
+    return PyObject_CallFunctionObjArgs((PyObject *)&DatagramType,
+                                        fd,
+                                        self, callback, data, priority, NULL);
+}
+
+
+/* Loop.relay(src, dst, callback[, data, priority]) -> pyev.Relay */
+PyDoc_STRVAR(Loop_relay_doc,
+"relay(src, dst, callback[, data, priority]) -> pyev.Relay");
+
+static PyObject *
+Loop_relay(Loop *self, PyObject *args)
+{
+    PyObject *src, *dst;
+    PyObject *callback, *data = Py_None, *priority = NULL;
+
+    if (!PyArg_UnpackTuple(args, "relay", 3, 5,
+                           &src, &dst,
+                           &callback, &data, &priority)) {
+        return NULL;
+    }
+    return PyObject_CallFunctionObjArgs((PyObject *)&RelayType,
+                                        src, dst,
+                                        self, callback, data, priority, NULL);
+}
+
+
+/* Loop.filesender(fd, file, callback[, data, priority]) -> pyev.FileSender */
+PyDoc_STRVAR(Loop_filesender_doc,
+"filesender(fd, file, callback[, data, priority]) -> pyev.FileSender");
+
+static PyObject *
+Loop_filesender(Loop *self, PyObject *args)
+{
+    PyObject *fd, *file;
+    PyObject *callback, *data = Py_None, *priority = NULL;
+
+    if (!PyArg_UnpackTuple(args, "filesender", 3, 5,
+                           &fd, &file,
+                           &callback, &data, &priority)) {
+        return NULL;
+    }
+    return PyObject_CallFunctionObjArgs((PyObject *)&FileSenderType,
+                                        fd, file,
+                                        self, callback, data, priority, NULL);
+}
+
+
 /* Loop.timer(after, repeat, callback[, data, priority]) -> pyev.Timer */
 PyDoc_STRVAR(Loop_timer_doc,
 "timer(after, repeat, callback[, data, priority]) -> pyev.Timer");
@@ -384,6 +1268,27 @@ Loop_timer(Loop *self, PyObject *args)
 }
 
 
+/* Loop.timerwheel(resolution, callback[, data, priority]) -> pyev.TimerWheel */
+PyDoc_STRVAR(Loop_timerwheel_doc,
+"timerwheel(resolution, callback[, data, priority]) -> pyev.TimerWheel");
+
+static PyObject *
+Loop_timerwheel(Loop *self, PyObject *args)
+{
+    PyObject *resolution;
+    PyObject *callback, *data = Py_None, *priority = NULL;
+
+    if (!PyArg_UnpackTuple(args, "timerwheel", 2, 4,
+                           &resolution,
+                           &callback, &data, &priority)) {
+        return NULL;
+    }
+    return PyObject_CallFunctionObjArgs((PyObject *)&TimerWheelType,
+                                        resolution,
+                                        self, callback, data, priority, NULL);
+}
+
+
 #if EV_PERIODIC_ENABLE
 /* Loop.periodic(offset, interval, callback[, data, priority]) -> pyev.Periodic */
 PyDoc_STRVAR(Loop_periodic_doc,
@@ -586,11 +1491,41 @@ static PyMethodDef Loop_tp_methods[] = {
      METH_VARARGS, Loop_start_doc},
     {"stop", (PyCFunction)Loop_stop,
      METH_VARARGS, Loop_stop_doc},
+    {"set_pool", (PyCFunction)Loop_set_pool,
+     METH_VARARGS, Loop_set_pool_doc},
+    {"run_in_pool", (PyCFunction)Loop_run_in_pool,
+     METH_VARARGS | METH_KEYWORDS, Loop_run_in_pool_doc},
+    {"call_soon", (PyCFunction)Loop_call_soon,
+     METH_VARARGS, Loop_call_soon_doc},
+    {"call_later", (PyCFunction)Loop_call_later,
+     METH_VARARGS, Loop_call_later_doc},
+    {"wait_readable", (PyCFunction)Loop_wait_readable,
+     METH_O, Loop_wait_readable_doc},
+    {"wait_writable", (PyCFunction)Loop_wait_writable,
+     METH_O, Loop_wait_writable_doc},
+    {"sleep", (PyCFunction)Loop_sleep,
+     METH_VARARGS, Loop_sleep_doc},
+    {"spawn", (PyCFunction)Loop_spawn,
+     METH_O, Loop_spawn_doc},
     /* watcher methods */
     {"io", (PyCFunction)Loop_io,
      METH_VARARGS, Loop_io_doc},
+    {"io_modify_many", (PyCFunction)Loop_io_modify_many,
+     METH_VARARGS, Loop_io_modify_many_doc},
+    {"stream", (PyCFunction)Loop_stream,
+     METH_VARARGS, Loop_stream_doc},
+    {"acceptor", (PyCFunction)Loop_acceptor,
+     METH_VARARGS, Loop_acceptor_doc},
+    {"datagram", (PyCFunction)Loop_datagram,
+     METH_VARARGS, Loop_datagram_doc},
+    {"relay", (PyCFunction)Loop_relay,
+     METH_VARARGS, Loop_relay_doc},
+    {"filesender", (PyCFunction)Loop_filesender,
+     METH_VARARGS, Loop_filesender_doc},
     {"timer", (PyCFunction)Loop_timer,
      METH_VARARGS, Loop_timer_doc},
+    {"timerwheel", (PyCFunction)Loop_timerwheel,
+     METH_VARARGS, Loop_timerwheel_doc},
 #if EV_PERIODIC_ENABLE
     {"periodic", (PyCFunction)Loop_periodic,
      METH_VARARGS, Loop_periodic_doc},
@@ -638,6 +1573,8 @@ static PyMethodDef Loop_tp_methods[] = {
 /* LoopType.tp_members */
 static PyMemberDef Loop_tp_members[] = {
     {"data", T_OBJECT, offsetof(Loop, data), 0, NULL},
+    {"spins", T_ULONG, offsetof(Loop, spins), READONLY, NULL},
+    {"sleeps", T_ULONG, offsetof(Loop, sleeps), READONLY, NULL},
     {NULL}  /* Sentinel */
 };
 
@@ -701,6 +1638,25 @@ Loop_callback_set(Loop *self, PyObject *value, void *closure)
 }
 
 
+/* Loop.batch */
+static PyObject *
+Loop_batch_get(Loop *self, void *closure)
+{
+    if (self->batch) {
+        Py_INCREF(self->batch);
+        return self->batch;
+    }
+    Py_RETURN_NONE;
+}
+
+static int
+Loop_batch_set(Loop *self, PyObject *value, void *closure)
+{
+    PYEV_PROTECTED_ATTRIBUTE(value);
+    return Loop_SetBatch(self, value);
+}
+
+
 /* Loop.io_interval/Loop.timeout_interval */
 static PyObject *
 Loop_interval_get(Loop *self, void *closure)
@@ -727,6 +1683,25 @@ Loop_interval_set(Loop *self, PyObject *value, void *closure)
 }
 
 
+/* Loop.busy_poll */
+static PyObject *
+Loop_busy_poll_get(Loop *self, void *closure)
+{
+    return PyFloat_FromDouble(self->busy_poll);
+}
+
+static int
+Loop_busy_poll_set(Loop *self, PyObject *value, void *closure)
+{
+    PYEV_PROTECTED_ATTRIBUTE(value);
+    double busy_poll = PyFloat_AsDouble(value);
+    if (busy_poll == -1.0 && PyErr_Occurred()) {
+        return -1;
+    }
+    return Loop_SetBusyPoll(self, busy_poll);
+}
+
+
 /* Loop.debug */
 static PyObject *
 Loop_debug_get(Loop *self, void *closure)
@@ -761,10 +1736,14 @@ static PyGetSetDef Loop_tp_getsets[] = {
      Readonly_attribute_set, NULL, NULL},
     {"callback", (getter)Loop_callback_get,
      (setter)Loop_callback_set, NULL, NULL},
+    {"batch", (getter)Loop_batch_get,
+     (setter)Loop_batch_set, NULL, NULL},
     {"io_interval", (getter)Loop_interval_get,
      (setter)Loop_interval_set, NULL, (void *)1},
     {"timeout_interval", (getter)Loop_interval_get,
      (setter)Loop_interval_set, NULL, NULL},
+    {"busy_poll", (getter)Loop_busy_poll_get,
+     (setter)Loop_busy_poll_set, NULL, NULL},
     {"debug", (getter)Loop_debug_get,
      (setter)Loop_debug_set, NULL, NULL},
     {NULL}  /* Sentinel */
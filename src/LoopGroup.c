@@ -0,0 +1,410 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+/* runs the submitted callables, or breaks the loop when the group stops */
+static void
+LoopGroup_Callback(struct ev_loop *loop, ev_async *async, int revents)
+{
+    LoopGroupMember *member = async->data;
+    PyObject *queue, *callable, *pyresult;
+    Py_ssize_t i;
+
+    if (PyList_GET_SIZE(member->queue)) {
+        /* callables submitted while we run these go to the next round */
+        queue = member->queue;
+        member->queue = PyList_New(0);
+        if (!member->queue) {
+            member->queue = queue;
+            PYEV_LOOP_EXIT(loop);
+            return;
+        }
+        for (i = 0; i < PyList_GET_SIZE(queue); i++) {
+            callable = PyList_GET_ITEM(queue, i);
+            pyresult = PyObject_CallFunctionObjArgs(callable, member->loop,
+                                                    NULL);
+            if (!pyresult) {
+                Loop_WarnOrStop(member->loop, callable);
+                if (PyErr_Occurred()) {
+                    break;
+                }
+            }
+            else {
+                Py_DECREF(pyresult);
+            }
+        }
+        Py_DECREF(queue);
+    }
+    if (member->stopping) {
+        ev_break(loop, EVBREAK_ALL);
+    }
+}
+
+
+/* thread body */
+static void
+LoopGroup_Run(void *arg)
+{
+    LoopGroupMember *member = arg;
+    PyGILState_STATE gstate = PyGILState_Ensure();
+
+    PYEV_BEGIN_LOCK(member->loop);
+    ev_run(member->loop->loop, 0);
+    PYEV_END_LOCK();
+    if (PyErr_Occurred()) {
+        PyErr_WriteUnraisable((PyObject *)member->loop);
+    }
+    member->running = 0;
+    PyThread_release_lock(member->done);
+    Py_DECREF(member->group);
+    PyGILState_Release(gstate);
+}
+
+
+/* wait for the threads to be done, but not for the one we are running in */
+static void
+LoopGroup_Join(LoopGroup *self)
+{
+    long ident = (long)PyThread_get_thread_ident();
+    Py_ssize_t i;
+
+    for (i = 0; i < self->count; i++) {
+        LoopGroupMember *member = &self->members[i];
+        if (member->ident == -1 || member->ident == ident) {
+            continue;
+        }
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(member->done, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+        PyThread_release_lock(member->done);
+        member->ident = -1;
+    }
+}
+
+
+/*******************************************************************************
+* LoopGroupType
+*******************************************************************************/
+
+/* LoopGroupType.tp_doc */
+PyDoc_STRVAR(LoopGroup_tp_doc,
+"LoopGroup(n[, flags=EVFLAG_AUTO])");
+
+
+/* LoopGroupType.tp_traverse */
+static int
+LoopGroup_tp_traverse(LoopGroup *self, visitproc visit, void *arg)
+{
+    Py_ssize_t i;
+
+    Py_VISIT(self->loops);
+    for (i = 0; i < self->count; i++) {
+        Py_VISIT(self->members[i].queue);
+    }
+    return 0;
+}
+
+
+/* LoopGroupType.tp_clear */
+static int
+LoopGroup_tp_clear(LoopGroup *self)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < self->count; i++) {
+        LoopGroupMember *member = &self->members[i];
+        if (member->loop) {
+            ev_async_stop(member->loop->loop, &member->async);
+            member->loop = NULL;
+        }
+        Py_CLEAR(member->queue);
+    }
+    Py_CLEAR(self->loops);
+    return 0;
+}
+
+
+/* LoopGroupType.tp_dealloc */
+static void
+LoopGroup_tp_dealloc(LoopGroup *self)
+{
+    Py_ssize_t i;
+
+    PyObject_GC_UnTrack(self);
+    LoopGroup_tp_clear(self);
+    if (self->members) {
+        for (i = 0; i < self->count; i++) {
+            if (self->members[i].done) {
+                PyThread_free_lock(self->members[i].done);
+            }
+        }
+        PyMem_Free(self->members);
+        self->members = NULL;
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+/* LoopGroup.start() */
+PyDoc_STRVAR(LoopGroup_start_doc,
+"start()");
+
+static PyObject *
+LoopGroup_start(LoopGroup *self)
+{
+    Py_ssize_t i;
+
+    if (!self->loops) {
+        PyErr_SetString(Error, "LoopGroup has been cleared");
+        return NULL;
+    }
+    for (i = 0; i < self->count; i++) {
+        if (self->members[i].ident != -1) {
+            PyErr_SetString(Error, "LoopGroup already started");
+            return NULL;
+        }
+    }
+#if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#endif
+    for (i = 0; i < self->count; i++) {
+        LoopGroupMember *member = &self->members[i];
+        member->stopping = 0;
+        member->running = 1;
+        PyThread_acquire_lock(member->done, WAIT_LOCK);
+        /* each thread holds a reference to the group */
+        Py_INCREF(self);
+        member->ident = (long)PyThread_start_new_thread(LoopGroup_Run, member);
+        if (member->ident == -1) {
+            member->running = 0;
+            PyThread_release_lock(member->done);
+            Py_DECREF(self);
+            PyErr_SetString(Error, "could not start thread");
+            return NULL;
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* LoopGroup.stop() */
+PyDoc_STRVAR(LoopGroup_stop_doc,
+"stop()");
+
+static PyObject *
+LoopGroup_stop(LoopGroup *self)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < self->count; i++) {
+        LoopGroupMember *member = &self->members[i];
+        if (member->running && member->loop) {
+            member->stopping = 1;
+            ev_async_send(member->loop->loop, &member->async);
+        }
+    }
+    LoopGroup_Join(self);
+    Py_RETURN_NONE;
+}
+
+
+/* LoopGroup.submit(index, callable) -> int */
+PyDoc_STRVAR(LoopGroup_submit_doc,
+"submit(index, callable) -> int");
+
+static PyObject *
+LoopGroup_submit(LoopGroup *self, PyObject *args)
+{
+    PyObject *pyindex, *callable;
+    LoopGroupMember *member;
+    Py_ssize_t index;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "OO:submit", &pyindex, &callable)) {
+        return NULL;
+    }
+    if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+    if (!self->loops) {
+        PyErr_SetString(Error, "LoopGroup has been cleared");
+        return NULL;
+    }
+    if (pyindex == Py_None) {
+        PYEV_BEGIN_LOCK(self);
+        index = self->next++;
+        if (self->next == self->count) {
+            self->next = 0;
+        }
+        PYEV_END_LOCK();
+    }
+    else {
+        index = PyNumber_AsSsize_t(pyindex, PyExc_IndexError);
+        if (index == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        if (index < 0 || index >= self->count) {
+            PyErr_SetString(PyExc_IndexError, "index out of range");
+            return NULL;
+        }
+    }
+    member = &self->members[index];
+    /* the loop swaps its queue under the same lock */
+    PYEV_BEGIN_LOCK(member->loop);
+    result = PyList_Append(member->queue, callable);
+    PYEV_END_LOCK();
+    if (result) {
+        return NULL;
+    }
+    ev_async_send(member->loop->loop, &member->async);
+    return PyInt_FromSsize_t(index);
+}
+
+
+/* LoopGroupType.tp_methods */
+static PyMethodDef LoopGroup_tp_methods[] = {
+    {"start", (PyCFunction)LoopGroup_start,
+     METH_NOARGS, LoopGroup_start_doc},
+    {"stop", (PyCFunction)LoopGroup_stop,
+     METH_NOARGS, LoopGroup_stop_doc},
+    {"submit", (PyCFunction)LoopGroup_submit,
+     METH_VARARGS, LoopGroup_submit_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* LoopGroupType.tp_members */
+static PyMemberDef LoopGroup_tp_members[] = {
+    {"loops", T_OBJECT, offsetof(LoopGroup, loops), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* LoopGroup.running */
+static PyObject *
+LoopGroup_running_get(LoopGroup *self, void *closure)
+{
+    Py_ssize_t i, running = 0;
+
+    for (i = 0; i < self->count; i++) {
+        running += self->members[i].running;
+    }
+    return PyInt_FromSsize_t(running);
+}
+
+
+/* LoopGroupType.tp_getsets */
+static PyGetSetDef LoopGroup_tp_getsets[] = {
+    {"running", (getter)LoopGroup_running_get,
+     Readonly_attribute_set, NULL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* LoopGroupType.tp_new */
+static PyObject *
+LoopGroup_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Py_ssize_t count, i;
+    unsigned int flags = EVFLAG_AUTO;
+    LoopGroup *self;
+    Loop *loop;
+    ev_async *async;
+
+    static char *kwlist[] = {"n", "flags", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "n|I:__new__", kwlist,
+                                     &count, &flags)) {
+        return NULL;
+    }
+    if (count <= 0) {
+        PyErr_SetString(PyExc_ValueError, "'n' must be positive");
+        return NULL;
+    }
+    self = (LoopGroup *)type->tp_alloc(type, 0);
+    if (!self) {
+        return NULL;
+    }
+    self->members = PyMem_Malloc(count * sizeof(LoopGroupMember));
+    if (!self->members) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    memset(self->members, 0, count * sizeof(LoopGroupMember));
+    self->count = count;
+    self->loops = PyTuple_New(count);
+    if (!self->loops) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        LoopGroupMember *member = &self->members[i];
+        member->ident = -1;
+        member->group = self;
+        member->done = PyThread_allocate_lock();
+        member->queue = PyList_New(0);
+        if (!member->done || !member->queue) {
+            if (!PyErr_Occurred()) {
+                PyErr_NoMemory();
+            }
+            Py_DECREF(self);
+            return NULL;
+        }
+        loop = (Loop *)PyObject_CallFunction((PyObject *)&LoopType, "I", flags);
+        if (!loop) {
+            Py_DECREF(self);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(self->loops, i, (PyObject *)loop);
+        member->loop = loop;
+        async = &member->async;
+        ev_async_init(async, LoopGroup_Callback);
+        async->data = member;
+        ev_async_start(loop->loop, async);
+    }
+    return (PyObject *)self;
+}
+
+
+/* LoopGroupType */
+static PyTypeObject LoopGroupType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.LoopGroup",                         /*tp_name*/
+    sizeof(LoopGroup),                        /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)LoopGroup_tp_dealloc,         /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /*tp_flags*/
+    LoopGroup_tp_doc,                         /*tp_doc*/
+    (traverseproc)LoopGroup_tp_traverse,      /*tp_traverse*/
+    (inquiry)LoopGroup_tp_clear,              /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    LoopGroup_tp_methods,                     /*tp_methods*/
+    LoopGroup_tp_members,                     /*tp_members*/
+    LoopGroup_tp_getsets,                     /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    0,                                        /*tp_init*/
+    0,                                        /*tp_alloc*/
+    LoopGroup_tp_new,                         /*tp_new*/
+};
@@ -157,7 +157,7 @@ Periodic_tp_init(Watcher *self, PyObject *args, PyObject *kwargs)
 static PyTypeObject PeriodicType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Periodic",                          /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_periodic),  /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
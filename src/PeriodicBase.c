@@ -39,11 +39,15 @@ static PyGetSetDef PeriodicBase_tp_getsets[] = {
 };
 
 
+/* PeriodicBaseType operations */
+PYEV_WATCHER_OPS(ev_periodic, EV_PERIODIC, 0);
+
+
 /* PeriodicBaseType.tp_new */
 static PyObject *
 PeriodicBase_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_PERIODIC, sizeof(ev_periodic));
+    return (PyObject *)Watcher_New(type, &ev_periodic_ops);
 }
 
 
@@ -51,7 +55,7 @@ PeriodicBase_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject PeriodicBaseType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.PeriodicBase",                      /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_periodic),  /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
@@ -0,0 +1,274 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_POOL_SIZE 4
+#define PYEV_POOL_MAXSIZE 1024
+
+
+/* free a task and drop its objects */
+void
+Pool_FreeTask(PoolTask *task)
+{
+    Py_DECREF(task->callable);
+    Py_DECREF(task->args);
+    Py_DECREF(task->callback);
+    Py_XDECREF(task->result);
+    Py_XDECREF(task->error);
+    PyMem_Free(task);
+}
+
+
+/* free a chain of tasks */
+void
+Pool_FreeTasks(PoolTask *task)
+{
+    PoolTask *next;
+
+    while (task) {
+        next = task->next;
+        Pool_FreeTask(task);
+        task = next;
+    }
+}
+
+
+/* hand a task back to the loop, only the first completion of a batch wakes it
+   up, the others find the stack non-empty and know a wakeup is on its way */
+void
+Pool_Complete(Pool *self, PoolTask *task)
+{
+    PoolTask *head = __atomic_load_n(&self->completed, __ATOMIC_RELAXED);
+
+    do {
+        task->next = head;
+    } while (!__atomic_compare_exchange_n(&self->completed, &head, task, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    if (!head) {
+        ev_async_send(self->loop, &self->async);
+    }
+}
+
+
+/* take every completed task, oldest first */
+PoolTask *
+Pool_Pop(Pool *self)
+{
+    PoolTask *task, *next, *result = NULL;
+
+    task = __atomic_exchange_n(&self->completed, NULL, __ATOMIC_ACQUIRE);
+    while (task) {
+        next = task->next;
+        task->next = result;
+        result = task;
+        task = next;
+    }
+    return result;
+}
+
+
+/* call the callable, keep the result or the exception for the loop thread */
+void
+Pool_Run(PoolTask *task)
+{
+    PyObject *type, *value, *traceback;
+
+    task->result = PyObject_Call(task->callable, task->args, NULL);
+    if (!task->result) {
+        PyErr_Fetch(&type, &value, &traceback);
+        PyErr_NormalizeException(&type, &value, &traceback);
+#if PY_MAJOR_VERSION >= 3
+        if (value && traceback) {
+            PyException_SetTraceback(value, traceback);
+        }
+#endif
+        task->error = value;
+        Py_XDECREF(type);
+        Py_XDECREF(traceback);
+    }
+}
+
+
+/* worker thread body, the GIL is only held while running a task */
+static void
+Pool_Work(void *arg)
+{
+    Pool *self = arg;
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PyThreadState *tstate = PyEval_SaveThread();
+    PoolTask *task;
+
+    pthread_mutex_lock(&self->mutex);
+    for (;;) {
+        while (!self->first && !self->shutdown) {
+            pthread_cond_wait(&self->ready, &self->mutex);
+        }
+        if (self->shutdown) {
+            break;
+        }
+        task = self->first;
+        if (!(self->first = task->next)) {
+            self->last = NULL;
+        }
+        self->queued--;
+        pthread_cond_signal(&self->room);
+        pthread_mutex_unlock(&self->mutex);
+        PyEval_RestoreThread(tstate);
+        Pool_Run(task);
+        tstate = PyEval_SaveThread();
+        Pool_Complete(self, task);
+        pthread_mutex_lock(&self->mutex);
+    }
+    self->workers--;
+    pthread_cond_signal(&self->done);
+    pthread_mutex_unlock(&self->mutex);
+    PyEval_RestoreThread(tstate);
+    PyGILState_Release(gstate);
+}
+
+
+/* pool async callback, runs the callbacks of all completed tasks */
+static void
+Pool_Callback(struct ev_loop *loop, ev_async *async, int revents)
+{
+    Pool *self = async->data;
+    Loop *pyloop = ev_userdata(loop);
+    PoolTask *task, *next;
+    PyObject *pyresult;
+
+    /* a callback dropping the last reference to the loop would free us */
+    Py_INCREF(pyloop);
+    for (task = Pool_Pop(self); task; task = next) {
+        next = task->next;
+        self->outstanding--;
+        if (!PyErr_Occurred()) {
+            pyresult = Callback_Invoke(task->callback,
+                                       task->result ? task->result : Py_None,
+                                       task->error ? task->error : Py_None);
+            if (!pyresult) {
+                Loop_WarnOrStop(pyloop, task->callback);
+            }
+            else {
+                Py_DECREF(pyresult);
+            }
+        }
+        Pool_FreeTask(task);
+    }
+    if (!self->outstanding) {
+        /* don't keep the loop alive */
+        ev_async_stop(loop, async);
+    }
+    Py_DECREF(pyloop);
+}
+
+
+/* stop the workers (waiting for running tasks), and free the pool */
+void
+Pool_Destroy(Pool *self)
+{
+    /* the workers take the mutex without the GIL, never wait for the GIL
+       while holding it */
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&self->mutex);
+    self->shutdown = 1;
+    pthread_cond_broadcast(&self->ready);
+    while (self->workers) {
+        pthread_cond_wait(&self->done, &self->mutex);
+    }
+    pthread_mutex_unlock(&self->mutex);
+    Py_END_ALLOW_THREADS
+    ev_async_stop(self->loop, &self->async);
+    Pool_FreeTasks(self->first);
+    Pool_FreeTasks(Pool_Pop(self));
+    pthread_cond_destroy(&self->done);
+    pthread_cond_destroy(&self->room);
+    pthread_cond_destroy(&self->ready);
+    pthread_mutex_destroy(&self->mutex);
+    PyMem_Free(self);
+}
+
+
+/* create a pool and start its workers */
+Pool *
+Pool_New(struct ev_loop *loop, int size, Py_ssize_t maxsize)
+{
+    ev_async *async;
+    int i;
+
+    Pool *self = PyMem_Malloc(sizeof(Pool));
+    if (!self) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memset(self, 0, sizeof(Pool));
+    async = &self->async;
+    ev_async_init(async, Pool_Callback);
+    async->data = self;
+    self->loop = loop;
+    self->maxsize = maxsize;
+    pthread_mutex_init(&self->mutex, NULL);
+    pthread_cond_init(&self->ready, NULL);
+    pthread_cond_init(&self->room, NULL);
+    pthread_cond_init(&self->done, NULL);
+#if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#endif
+    for (i = 0; i < size; i++) {
+        /* not running yet, no need to lock */
+        self->workers++;
+        if ((long)PyThread_start_new_thread(Pool_Work, self) == -1) {
+            self->workers--;
+            break;
+        }
+    }
+    if (!self->workers) {
+        Pool_Destroy(self);
+        PyErr_SetString(Error, "could not start thread");
+        return NULL;
+    }
+    return self;
+}
+
+
+/* queue callable(*args), blocks while the queue is full */
+int
+Pool_Submit(Pool *self, PyObject *callable, PyObject *args,
+            PyObject *callback)
+{
+    PoolTask *task = PyMem_Malloc(sizeof(PoolTask));
+    if (!task) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    Py_INCREF(callable);
+    task->callable = callable;
+    Py_INCREF(args);
+    task->args = args;
+    Py_INCREF(callback);
+    task->callback = callback;
+    task->result = NULL;
+    task->error = NULL;
+    task->next = NULL;
+    /* the task may complete as soon as it is queued, the async must already
+       be started by then */
+    if (!self->outstanding++) {
+        ev_async_start(self->loop, &self->async);
+    }
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&self->mutex);
+    while (self->queued >= self->maxsize) {
+        pthread_cond_wait(&self->room, &self->mutex);
+    }
+    if (self->last) {
+        self->last->next = task;
+    }
+    else {
+        self->first = task;
+    }
+    self->last = task;
+    self->queued++;
+    pthread_cond_signal(&self->ready);
+    pthread_mutex_unlock(&self->mutex);
+    Py_END_ALLOW_THREADS
+    return 0;
+}
@@ -7,11 +7,15 @@ PyDoc_STRVAR(Prepare_tp_doc,
 "Prepare(loop, callback[, data=None, priority=0])");
 
 
+/* PrepareType operations */
+PYEV_WATCHER_OPS(ev_prepare, EV_PREPARE, 0);
+
+
 /* PrepareType.tp_new */
 static PyObject *
 Prepare_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_PREPARE, sizeof(ev_prepare));
+    return (PyObject *)Watcher_New(type, &ev_prepare_ops);
 }
 
 
@@ -19,7 +23,7 @@ Prepare_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject PrepareType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Prepare",                           /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_prepare),   /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
@@ -0,0 +1,541 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_RELAY_CHUNK 65536
+#define PYEV_RELAY_MAX_READS 16
+
+
+/* close the pipe, from now on data goes through the buffer */
+void
+Relay_ClosePipe(Relay *self)
+{
+    if (self->pipe[0] >= 0) {
+        close(self->pipe[0]);
+        close(self->pipe[1]);
+        self->pipe[0] = self->pipe[1] = -1;
+    }
+}
+
+
+/* (re)open the pipe, keep using the buffer if that is not possible */
+void
+Relay_OpenPipe(Relay *self)
+{
+    Relay_ClosePipe(self);
+#ifdef SPLICE_F_MOVE
+    if (pipe2(self->pipe, O_NONBLOCK | O_CLOEXEC)) {
+        self->pipe[0] = self->pipe[1] = -1;
+    }
+#endif
+}
+
+
+/* move what is left in the pipe into the buffer and stop splicing */
+int
+Relay_Unsplice(Relay *self)
+{
+    Py_ssize_t result, length = 0;
+
+    if (!self->buffer) {
+        self->buffer = PyMem_Malloc(PYEV_RELAY_CHUNK);
+        if (!self->buffer) {
+            self->error = ENOMEM;
+            return -1;
+        }
+    }
+    while (length < self->pending) {
+        result = read(self->pipe[0], self->buffer + length,
+                      self->pending - length);
+        if (result <= 0) {
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            self->error = result ? errno : EIO;
+            return -1;
+        }
+        length += result;
+    }
+    Relay_ClosePipe(self);
+    self->start = 0;
+    return 0;
+}
+
+
+/* read from the source, returns 0 on EOF and -1 on error (errno is set) */
+Py_ssize_t
+Relay_Fill(Relay *self, int fd)
+{
+    Py_ssize_t result;
+
+#ifdef SPLICE_F_MOVE
+    if (self->pipe[1] >= 0) {
+        do {
+            result = splice(fd, NULL, self->pipe[1], NULL, PYEV_RELAY_CHUNK,
+                            SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        } while (result < 0 && errno == EINTR);
+        if (result >= 0 || errno != EINVAL) {
+            return result;
+        }
+        /* the source can't be spliced */
+        Relay_ClosePipe(self);
+    }
+#endif
+    if (!self->buffer) {
+        self->buffer = PyMem_Malloc(PYEV_RELAY_CHUNK);
+        if (!self->buffer) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    do {
+        result = read(fd, self->buffer, PYEV_RELAY_CHUNK);
+    } while (result < 0 && errno == EINTR);
+    self->start = 0;
+    return result;
+}
+
+
+/* write pending data to the destination, returns -1 on error */
+int
+Relay_Drain(Relay *self)
+{
+    int fd = self->output->fd;
+    Py_ssize_t result;
+
+    while (self->pending) {
+#ifdef SPLICE_F_MOVE
+        if (self->pipe[0] >= 0) {
+            result = splice(self->pipe[0], NULL, fd, NULL, self->pending,
+                            SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (result < 0 && errno == EINVAL) {
+                /* the destination can't be spliced */
+                if (Relay_Unsplice(self)) {
+                    return -1;
+                }
+                continue;
+            }
+        }
+        else
+#endif
+        {
+            result = write(fd, self->buffer + self->start, self->pending);
+        }
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            self->error = errno;
+            return -1;
+        }
+        self->start += result;
+        self->pending -= result;
+        self->transferred += result;
+        self->unreported += result;
+    }
+    return 0;
+}
+
+
+/* call the Python callback with the number of bytes transferred (or None) */
+void
+Relay_Invoke(Relay *self, struct ev_loop *loop, PyObject *transferred)
+{
+    PyObject *pyresult;
+
+    if (!transferred) {
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    self->unreported = 0;
+    pyresult = Callback_Invoke(((Watcher *)self)->callback,
+                               (PyObject *)self, transferred);
+    if (!pyresult) {
+        Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+    Py_DECREF(transferred);
+}
+
+
+/* watch the side that can make progress, report completion/progress */
+void
+Relay_Update(Relay *self, struct ev_loop *loop)
+{
+    Py_INCREF(self);
+    if (self->pending) {
+        /* backpressure, stop reading until the destination catches up */
+        Io_Modify((Watcher *)self, 0);
+        ev_io_start(loop, self->output);
+    }
+    else {
+        ev_io_stop(loop, self->output);
+        if (self->eof) {
+            Watcher_Stop((Watcher *)self);
+            Relay_Invoke(self, loop,
+                         PyLong_FromUnsignedLongLong(self->transferred));
+            goto finish;
+        }
+        Io_Modify((Watcher *)self, EV_READ);
+    }
+    if (self->threshold && self->unreported >= self->threshold) {
+        Relay_Invoke(self, loop,
+                     PyLong_FromUnsignedLongLong(self->transferred));
+    }
+
+finish:
+    Py_DECREF(self);
+}
+
+
+/* stop everything and report the error */
+void
+Relay_Fail(Relay *self, struct ev_loop *loop)
+{
+    Watcher_Stop((Watcher *)self);
+    Py_INCREF(self);
+    Py_INCREF(Py_None);
+    Relay_Invoke(self, loop, Py_None);
+    Py_DECREF(self);
+}
+
+
+/* relay source io callback */
+static void
+Relay_Callback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    Relay *self = io->data;
+    Py_ssize_t result;
+    int i;
+
+    if (revents & EV_ERROR) {
+        Watcher_Callback(loop, (ev_watcher *)io, revents);
+        return;
+    }
+    for (i = 0; i < PYEV_RELAY_MAX_READS && !self->pending; i++) {
+        result = Relay_Fill(self, io->fd);
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            self->error = errno;
+            Relay_Fail(self, loop);
+            return;
+        }
+        if (!result) {
+            self->eof = 1;
+            break;
+        }
+        self->pending = result;
+        if (Relay_Drain(self)) {
+            Relay_Fail(self, loop);
+            return;
+        }
+    }
+    Relay_Update(self, loop);
+}
+
+
+/* relay destination io callback */
+static void
+Relay_OutputCallback(struct ev_loop *loop, ev_io *output, int revents)
+{
+    Relay *self = output->data;
+
+    if (revents & EV_ERROR) {
+        self->error = EBADF;
+        Relay_Fail(self, loop);
+    }
+    else if (Relay_Drain(self)) {
+        Relay_Fail(self, loop);
+    }
+    else {
+        Relay_Update(self, loop);
+    }
+}
+
+
+/* set the Relay */
+int
+Relay_Set(Relay *self, PyObject *src, PyObject *dst)
+{
+    int fd;
+
+    if (Io_Set((Watcher *)self, src, EV_READ)) {
+        return -1;
+    }
+    fd = PyObject_AsFileDescriptor(dst);
+    if (fd < 0) {
+        return -1;
+    }
+    ev_io_set(self->output, fd, EV_WRITE);
+    /* drop whatever could be left in the pipe */
+    Relay_OpenPipe(self);
+    self->start = self->pending = 0;
+    self->transferred = self->unreported = 0;
+    self->eof = self->error = 0;
+    return 0;
+}
+
+
+/* set the Relay threshold */
+int
+Relay_SetThreshold(Relay *self, Py_ssize_t threshold)
+{
+    if (threshold < 0) {
+        PyErr_SetString(PyExc_ValueError, "'threshold' must be positive or 0");
+        return -1;
+    }
+    self->threshold = threshold;
+    return 0;
+}
+
+
+/*******************************************************************************
+* RelayType
+*******************************************************************************/
+
+/* RelayType.tp_doc */
+PyDoc_STRVAR(Relay_tp_doc,
+"Relay(src, dst, loop, callback[, data=None, priority=0, threshold=0])");
+
+
+/* RelayType.tp_dealloc */
+static void
+Relay_tp_dealloc(Relay *self)
+{
+    if (self->output) {
+        if (((Watcher *)self)->loop) {
+            ev_io_stop(((Watcher *)self)->loop->loop, self->output);
+        }
+        PyMem_Free(self->output);
+        self->output = NULL;
+    }
+    Relay_ClosePipe(self);
+    PyMem_Free(self->buffer);
+    self->buffer = NULL;
+    IoType.tp_dealloc((PyObject *)self);
+}
+
+
+/* Relay.set(src, dst) */
+PyDoc_STRVAR(Relay_set_doc,
+"set(src, dst)");
+
+static PyObject *
+Relay_set(Relay *self, PyObject *args)
+{
+    PyObject *src, *dst;
+
+    PYEV_WATCHER_SET((Watcher *)self);
+    if (!PyArg_ParseTuple(args, "OO:set", &src, &dst)) {
+        return NULL;
+    }
+    if (Relay_Set(self, src, dst)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* RelayType.tp_methods */
+static PyMethodDef Relay_tp_methods[] = {
+    {"set", (PyCFunction)Relay_set,
+     METH_VARARGS, Relay_set_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* RelayType.tp_members */
+static PyMemberDef Relay_tp_members[] = {
+    {"transferred", T_ULONGLONG, offsetof(Relay, transferred), READONLY, NULL},
+    {"pending", T_PYSSIZET, offsetof(Relay, pending), READONLY, NULL},
+    {"error", T_INT, offsetof(Relay, error), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* Relay.threshold */
+static PyObject *
+Relay_threshold_get(Relay *self, void *closure)
+{
+    return PyInt_FromSsize_t(self->threshold);
+}
+
+static int
+Relay_threshold_set(Relay *self, PyObject *value, void *closure)
+{
+    PYEV_PROTECTED_ATTRIBUTE(value);
+    Py_ssize_t threshold = PyNumber_AsSsize_t(value, PyExc_OverflowError);
+    if (threshold == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    return Relay_SetThreshold(self, threshold);
+}
+
+
+/* Relay.dst */
+static PyObject *
+Relay_dst_get(Relay *self, void *closure)
+{
+    return PyInt_FromLong(self->output->fd);
+}
+
+
+/* Relay.spliced */
+static PyObject *
+Relay_spliced_get(Relay *self, void *closure)
+{
+    return PyBool_FromLong(self->pipe[0] >= 0);
+}
+
+
+/* RelayType.tp_getsets */
+static PyGetSetDef Relay_tp_getsets[] = {
+    {"threshold", (getter)Relay_threshold_get,
+     (setter)Relay_threshold_set, NULL, NULL},
+    {"dst", (getter)Relay_dst_get,
+     Readonly_attribute_set, NULL, NULL},
+    {"spliced", (getter)Relay_spliced_get,
+     Readonly_attribute_set, NULL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* RelayType.tp_init */
+static int
+Relay_tp_init(Relay *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *src, *dst;
+    Loop *loop;
+    PyObject *callback, *data = NULL;
+    int priority = 0;
+    Py_ssize_t threshold = 0;
+
+    static char *kwlist[] = {"src", "dst",
+                             "loop", "callback", "data", "priority",
+                             "threshold", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO!O|Oin:__init__", kwlist,
+            &src, &dst,
+            &LoopType, &loop, &callback, &data, &priority,
+            &threshold)) {
+        return -1;
+    }
+    if (Watcher_Init((Watcher *)self, loop, callback, data, priority) ||
+        Relay_SetThreshold(self, threshold)) {
+        return -1;
+    }
+    return Relay_Set(self, src, dst);
+}
+
+
+/* RelayType operations, dst is watched along with src */
+static void
+Relay_OpsStart(struct ev_loop *loop, ev_watcher *watcher)
+{
+    Relay *self = watcher->data;
+
+    ev_io_start(loop, (ev_io *)watcher);
+    if (self->pending) {
+        ev_io_start(loop, self->output);
+    }
+}
+
+
+static void
+Relay_OpsStop(struct ev_loop *loop, ev_watcher *watcher)
+{
+    Relay *self = watcher->data;
+
+    if (self->output) {
+        ev_io_stop(loop, self->output);
+    }
+    ev_io_stop(loop, (ev_io *)watcher);
+}
+
+
+static int
+Relay_OpsIsActive(ev_watcher *watcher)
+{
+    Relay *self = watcher->data;
+
+    return ev_is_active(watcher) ||
+           (self->output && ev_is_active(self->output));
+}
+
+
+static const WatcherOps Relay_ops = {
+    EV_IO, sizeof(ev_io), Relay_OpsStart, Relay_OpsStop, Relay_OpsIsActive, 0
+};
+
+
+/* RelayType.tp_new */
+static PyObject *
+Relay_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Relay *self = (Relay *)IoType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->pipe[0] = self->pipe[1] = -1;
+    self->output = PyMem_Malloc(sizeof(ev_io));
+    if (!self->output) {
+        PyErr_NoMemory();
+        Py_DECREF(self);
+        return NULL;
+    }
+    ev_io_init(self->output, Relay_OutputCallback, -1, EV_WRITE);
+    self->output->data = self;
+    ev_set_cb((ev_io *)((Watcher *)self)->watcher, Relay_Callback);
+    ((Watcher *)self)->ops = &Relay_ops;
+    return (PyObject *)self;
+}
+
+
+/* RelayType */
+static PyTypeObject RelayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.Relay",                             /*tp_name*/
+    PYEV_WATCHER_SIZE(Relay, ev_io),          /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)Relay_tp_dealloc,             /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    Relay_tp_doc,                             /*tp_doc*/
+    0,                                        /*tp_traverse*/
+    0,                                        /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    Relay_tp_methods,                         /*tp_methods*/
+    Relay_tp_members,                         /*tp_members*/
+    Relay_tp_getsets,                         /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    (initproc)Relay_tp_init,                  /*tp_init*/
+    0,                                        /*tp_alloc*/
+    Relay_tp_new,                             /*tp_new*/
+};
@@ -34,7 +34,7 @@ Scheduler_Schedule(ev_periodic *periodic, double now)
         self->err_fatal = 1;
         goto fail;
     }
-    pyresult = PyObject_CallFunctionObjArgs(self->scheduler, self, pynow, NULL);
+    pyresult = Callback_Invoke(self->scheduler, (PyObject *)self, pynow);
     if (!pyresult) {
         goto fail;
     }
@@ -197,7 +197,7 @@ Scheduler_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject SchedulerType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Scheduler",                         /*tp_name*/
-    sizeof(Scheduler),                        /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Scheduler, ev_periodic), /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     (destructor)Scheduler_tp_dealloc,         /*tp_dealloc*/
     0,                                        /*tp_print*/
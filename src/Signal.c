@@ -88,11 +88,15 @@ Signal_tp_init(Watcher *self, PyObject *args, PyObject *kwargs)
 }
 
 
+/* SignalType operations */
+PYEV_WATCHER_OPS(ev_signal, EV_SIGNAL, 0);
+
+
 /* SignalType.tp_new */
 static PyObject *
 Signal_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_SIGNAL, sizeof(ev_signal));
+    return (PyObject *)Watcher_New(type, &ev_signal_ops);
 }
 
 
@@ -100,7 +104,7 @@ Signal_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject SignalType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Signal",                            /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_signal),    /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
@@ -0,0 +1,952 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_STREAM_BUFSIZE 8192
+#define PYEV_STREAM_MAX_READS 16
+#define PYEV_STREAM_IOV_MAX 64
+#define PYEV_STREAM_MAX_FRAME (16 * 1024 * 1024)
+
+
+/* make room for at least self->bufsize bytes at the end of the buffer */
+int
+Stream_Reserve(Stream *self)
+{
+    Py_ssize_t length = self->end - self->start;
+    Py_ssize_t size = self->size;
+    PyObject *buffer;
+
+    if (self->size - self->end >= self->bufsize) {
+        return 0;
+    }
+    /* frames handed out as memoryviews keep a reference to the buffer, in
+       that case it must not be touched, only appended to */
+    if (self->start && Py_REFCNT(self->buffer) == 1) {
+        /* compact first, unconsumed data is usually small */
+        if (length) {
+            memmove(PyByteArray_AS_STRING(self->buffer),
+                    PyByteArray_AS_STRING(self->buffer) + self->start, length);
+        }
+        self->start = 0;
+        self->end = length;
+        if (self->size - self->end >= self->bufsize) {
+            return 0;
+        }
+    }
+    if (!size) {
+        size = self->bufsize;
+    }
+    while (size - length < self->bufsize) {
+        size *= 2;
+    }
+    if (self->buffer && Py_REFCNT(self->buffer) == 1) {
+        if (PyByteArray_Resize(self->buffer, size)) {
+            return -1;
+        }
+    }
+    else {
+        /* leave the old buffer to the frames still referencing it */
+        buffer = PyByteArray_FromStringAndSize(NULL, size);
+        if (!buffer) {
+            return -1;
+        }
+        if (length) {
+            memcpy(PyByteArray_AS_STRING(buffer),
+                   PyByteArray_AS_STRING(self->buffer) + self->start, length);
+        }
+        Py_XDECREF(self->buffer);
+        self->buffer = buffer;
+        self->start = 0;
+        self->end = length;
+    }
+    self->size = size;
+    return 0;
+}
+
+
+/* drop the buffer if it is empty, or shrink it back after a burst */
+void
+Stream_Trim(Stream *self)
+{
+    if (self->start != self->end) {
+        return;
+    }
+    self->start = self->end = self->scanned = 0;
+    if (self->buffer && Py_REFCNT(self->buffer) > 1) {
+        Py_CLEAR(self->buffer);
+        self->size = 0;
+    }
+    else if (self->size > self->bufsize) {
+        if (PyByteArray_Resize(self->buffer, self->bufsize)) {
+            PyErr_Clear();
+        }
+        else {
+            self->size = self->bufsize;
+        }
+    }
+}
+
+
+/* read everything available on the fd, returns 0 on EOF, -1 on error */
+Py_ssize_t
+Stream_Read(Stream *self)
+{
+    int fd = ((ev_io *)((Watcher *)self)->watcher)->fd;
+    Py_ssize_t result, total = 0;
+    int i;
+
+    for (i = 0; i < PYEV_STREAM_MAX_READS; i++) {
+        if (Stream_Reserve(self)) {
+            return -2;
+        }
+        result = read(fd, PyByteArray_AS_STRING(self->buffer) + self->end,
+                      self->size - self->end);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (total) {
+                /* deliver what we have, the error will show up again */
+                break;
+            }
+            self->error = errno;
+            return -1;
+        }
+        if (!result) {
+            /* EOF, deliver pending data first */
+            if (!total) {
+                return 0;
+            }
+            break;
+        }
+        self->end += result;
+        total += result;
+        if (self->end < self->size) {
+            /* short read, the socket is drained */
+            break;
+        }
+    }
+    return total;
+}
+
+
+/* release all the buffers still waiting in the write queue */
+void
+Stream_ClearQueue(Stream *self)
+{
+    while (self->queue_head < self->queue_tail) {
+        PyBuffer_Release(&self->queue[self->queue_head++]);
+    }
+    self->queue_head = self->queue_tail = 0;
+    self->offset = self->queued = 0;
+}
+
+
+/* append a buffer to the write queue and start watching for EV_WRITE */
+int
+Stream_Enqueue(Stream *self, Py_buffer *view, Py_ssize_t offset)
+{
+    Py_ssize_t length = self->queue_tail - self->queue_head;
+    Py_ssize_t size;
+    Py_buffer *queue;
+
+    if (self->queue_tail == self->queue_size) {
+        if (self->queue_head) {
+            memmove(self->queue, self->queue + self->queue_head,
+                    length * sizeof(Py_buffer));
+            self->queue_head = 0;
+            self->queue_tail = length;
+        }
+        else {
+            size = self->queue_size ? self->queue_size * 2 : 8;
+            queue = PyMem_Realloc(self->queue, size * sizeof(Py_buffer));
+            if (!queue) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            self->queue = queue;
+            self->queue_size = size;
+        }
+    }
+    self->queue[self->queue_tail++] = *view;
+    self->queued += view->len - offset;
+    if (!length) {
+        self->offset = offset;
+        Io_Modify((Watcher *)self, self->eof ? EV_WRITE : EV_READ | EV_WRITE);
+    }
+    return 0;
+}
+
+
+/* drop written bytes from the head of the write queue */
+void
+Stream_Dequeue(Stream *self, Py_ssize_t written)
+{
+    Py_buffer *view;
+
+    self->queued -= written;
+    while (written) {
+        view = &self->queue[self->queue_head];
+        if (written < view->len - self->offset) {
+            self->offset += written;
+            return;
+        }
+        written -= view->len - self->offset;
+        PyBuffer_Release(view);
+        self->queue_head++;
+        self->offset = 0;
+    }
+    if (self->queue_head == self->queue_tail) {
+        self->queue_head = self->queue_tail = 0;
+        if (self->eof) {
+            /* flushed after EOF, nothing left to watch */
+            Watcher_Stop((Watcher *)self);
+        }
+        else {
+            Io_Modify((Watcher *)self, EV_READ);
+        }
+    }
+}
+
+
+/* write as much of the queue as the fd accepts, returns -1 on error */
+int
+Stream_Flush(Stream *self)
+{
+    int fd = ((ev_io *)((Watcher *)self)->watcher)->fd;
+    struct iovec iov[PYEV_STREAM_IOV_MAX];
+    Py_ssize_t i, result, length;
+    int count;
+
+    while (self->queue_head < self->queue_tail) {
+        length = 0;
+        for (i = self->queue_head, count = 0;
+             i < self->queue_tail && count < PYEV_STREAM_IOV_MAX;
+             i++, count++) {
+            iov[count].iov_base = (char *)self->queue[i].buf;
+            iov[count].iov_len = self->queue[i].len;
+            length += self->queue[i].len;
+        }
+        iov[0].iov_base = (char *)iov[0].iov_base + self->offset;
+        iov[0].iov_len -= self->offset;
+        length -= self->offset;
+        result = writev(fd, iov, count);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            self->error = errno;
+            return -1;
+        }
+        Stream_Dequeue(self, result);
+        if (result < length) {
+            /* the kernel buffer is full, wait for the next EV_WRITE */
+            break;
+        }
+    }
+    return 0;
+}
+
+
+/* call the Python callback, returns the number of bytes consumed */
+Py_ssize_t
+Stream_Deliver(Stream *self, PyObject *data)
+{
+    Watcher *watcher = (Watcher *)self;
+    PyObject *pyresult;
+    Py_ssize_t consumed;
+
+    pyresult = Callback_Invoke(watcher->callback, (PyObject *)self, data);
+    if (!pyresult) {
+        return -1;
+    }
+    if (data == Py_None) {
+        Py_DECREF(pyresult);
+        return 0;
+    }
+    if (pyresult == Py_None) {
+        Py_DECREF(pyresult);
+        return PyBytes_GET_SIZE(data);
+    }
+    consumed = PyNumber_AsSsize_t(pyresult, PyExc_OverflowError);
+    Py_DECREF(pyresult);
+    if (consumed == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (consumed < 0 || consumed > PyBytes_GET_SIZE(data)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "callback returned an invalid number of bytes");
+        return -1;
+    }
+    return consumed;
+}
+
+
+/* hand data (or None) to the Python callback */
+void
+Stream_Invoke(Stream *self, struct ev_loop *loop, PyObject *data)
+{
+    unsigned long generation = self->generation;
+    Py_ssize_t result;
+
+    if (!data) {
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    Py_INCREF(self);
+    result = Stream_Deliver(self, data);
+    if (result < 0) {
+        Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+    }
+    else if (self->generation == generation) {
+        /* the callback did not set() a new fd, which resets the buffer */
+        self->start += result;
+        Stream_Trim(self);
+    }
+    Py_DECREF(data);
+    Py_DECREF(self);
+}
+
+
+/* find the next delimiter in data, starting at offset */
+Py_ssize_t
+Stream_FindDelimiter(Stream *self, const char *data, Py_ssize_t length,
+                     Py_ssize_t offset)
+{
+    const char *delimiter = PyBytes_AS_STRING(self->delimiter);
+    Py_ssize_t size = PyBytes_GET_SIZE(self->delimiter);
+    const char *p = data + offset, *end = data + length - size + 1;
+
+    /* libc's memchr is vectorized, let it skip to the candidates */
+    while (p < end) {
+        p = memchr(p, delimiter[0], end - p);
+        if (!p) {
+            break;
+        }
+        if (size == 1 || !memcmp(p + 1, delimiter + 1, size - 1)) {
+            return p - data;
+        }
+        p++;
+    }
+    return -1;
+}
+
+
+/* decode a length prefix */
+unsigned PY_LONG_LONG
+Stream_DecodePrefix(Stream *self, const unsigned char *data)
+{
+    unsigned PY_LONG_LONG result = 0;
+    int i;
+
+    if (self->little_endian) {
+        for (i = self->prefix - 1; i >= 0; i--) {
+            result = (result << 8) | data[i];
+        }
+    }
+    else {
+        for (i = 0; i < self->prefix; i++) {
+            result = (result << 8) | data[i];
+        }
+    }
+    return result;
+}
+
+
+/* append data[start:end] to frames as a memoryview */
+int
+Stream_AppendFrame(Stream *self, PyObject *frames, PyObject **base,
+                   Py_ssize_t start, Py_ssize_t end)
+{
+    PyObject *frame;
+    int result;
+
+    if (!*base) {
+        *base = PyMemoryView_FromObject(self->buffer);
+        if (!*base) {
+            return -1;
+        }
+    }
+    frame = PySequence_GetSlice(*base, self->start + start, self->start + end);
+    if (!frame) {
+        return -1;
+    }
+    result = PyList_Append(frames, frame);
+    Py_DECREF(frame);
+    return result;
+}
+
+
+/* split the complete frames off the buffer, returns None if one is invalid */
+PyObject *
+Stream_Split(Stream *self)
+{
+    const char *data = PyByteArray_AS_STRING(self->buffer) + self->start;
+    Py_ssize_t length = self->end - self->start, offset = 0, found;
+    unsigned PY_LONG_LONG size;
+    PyObject *frames, *base = NULL;
+
+    frames = PyList_New(0);
+    if (!frames) {
+        return NULL;
+    }
+    if (self->delimiter) {
+        /* don't scan again what has been scanned on previous reads */
+        found = self->scanned;
+        while ((found = Stream_FindDelimiter(self, data, length, found)) >= 0) {
+            if (Stream_AppendFrame(self, frames, &base, offset, found)) {
+                goto fail;
+            }
+            found = offset = found + PyBytes_GET_SIZE(self->delimiter);
+        }
+        if (length - offset - PyBytes_GET_SIZE(self->delimiter) >=
+                self->max_frame) {
+            /* no delimiter in sight, don't buffer forever */
+            goto toobig;
+        }
+        self->scanned = length - offset - PyBytes_GET_SIZE(self->delimiter) + 1;
+        if (self->scanned < 0) {
+            self->scanned = 0;
+        }
+    }
+    else {
+        while (length - offset >= self->prefix) {
+            size = Stream_DecodePrefix(self,
+                (const unsigned char *)data + offset);
+            if (size > (unsigned PY_LONG_LONG)self->max_frame) {
+                /* garbage (or abuse), better give up than try to buffer it */
+                goto toobig;
+            }
+            if ((Py_ssize_t)size > length - offset - self->prefix) {
+                break;
+            }
+            if (Stream_AppendFrame(self, frames, &base, offset + self->prefix,
+                                   offset + self->prefix + (Py_ssize_t)size)) {
+                goto fail;
+            }
+            offset += self->prefix + (Py_ssize_t)size;
+        }
+    }
+    Py_XDECREF(base);
+    self->start += offset;
+    return frames;
+
+toobig:
+    Py_XDECREF(base);
+    Py_DECREF(frames);
+    self->error = EMSGSIZE;
+    Py_RETURN_NONE;
+
+fail:
+    Py_XDECREF(base);
+    Py_DECREF(frames);
+    return NULL;
+}
+
+
+/* hand a list of frames to the Python callback */
+void
+Stream_DeliverFrames(Stream *self, struct ev_loop *loop, PyObject *frames)
+{
+    PyObject *pyresult;
+
+    Py_INCREF(self);
+    pyresult = Callback_Invoke(((Watcher *)self)->callback,
+                               (PyObject *)self, frames);
+    if (!pyresult) {
+        Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+    }
+    else {
+        Py_DECREF(pyresult);
+    }
+    Py_DECREF(frames);
+    Stream_Trim(self);
+    Py_DECREF(self);
+}
+
+
+/* hand the complete frames to the Python callback */
+void
+Stream_InvokeFrames(Stream *self, struct ev_loop *loop)
+{
+    PyObject *frames = Stream_Split(self);
+
+    if (!frames) {
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    if (frames == Py_None) {
+        ev_io_stop(loop, (ev_io *)((Watcher *)self)->watcher);
+        Stream_Invoke(self, loop, frames);
+        return;
+    }
+    if (!PyList_GET_SIZE(frames)) {
+        /* incomplete frame, wait for more */
+        Py_DECREF(frames);
+        return;
+    }
+    Stream_DeliverFrames(self, loop, frames);
+}
+
+
+/* on EOF, hand what is still buffered to the Python callback one last time,
+   as a last (incomplete) frame when framing is on */
+void
+Stream_InvokeRest(Stream *self, struct ev_loop *loop)
+{
+    PyObject *frames, *base = NULL;
+
+    if (self->start == self->end) {
+        return;
+    }
+    if (!self->delimiter && !self->prefix) {
+        Stream_Invoke(self, loop,
+            PyBytes_FromStringAndSize(
+                PyByteArray_AS_STRING(self->buffer) + self->start,
+                self->end - self->start));
+        return;
+    }
+    frames = PyList_New(0);
+    if (!frames ||
+        Stream_AppendFrame(self, frames, &base, 0, self->end - self->start)) {
+        Py_XDECREF(base);
+        Py_XDECREF(frames);
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    Py_DECREF(base);
+    self->start = self->end;
+    Stream_DeliverFrames(self, loop, frames);
+}
+
+
+/* stream io callback */
+static void
+Stream_Callback(struct ev_loop *loop, ev_io *io, int revents)
+{
+    Stream *self = io->data;
+    unsigned long generation;
+    Py_ssize_t result;
+
+    if (revents & EV_ERROR) {
+        Watcher_Callback(loop, (ev_watcher *)io, revents);
+        return;
+    }
+    if ((revents & EV_WRITE) && Stream_Flush(self)) {
+        ev_io_stop(loop, io);
+        Py_INCREF(Py_None);
+        Stream_Invoke(self, loop, Py_None);
+        return;
+    }
+    if (!(revents & EV_READ)) {
+        return;
+    }
+    result = Stream_Read(self);
+    if (result == -2) {
+        PYEV_LOOP_EXIT(loop);
+    }
+    else if (result > 0) {
+        if (self->delimiter || self->prefix) {
+            Stream_InvokeFrames(self, loop);
+        }
+        else {
+            Stream_Invoke(self, loop,
+                PyBytes_FromStringAndSize(
+                    PyByteArray_AS_STRING(self->buffer) + self->start,
+                    self->end - self->start));
+        }
+    }
+    else if (result) {
+        /* error, the watcher won't be of any use anymore */
+        ev_io_stop(loop, io);
+        Py_INCREF(Py_None);
+        Stream_Invoke(self, loop, Py_None);
+    }
+    else {
+        /* EOF, only keep watching for EV_WRITE while the queue is flushed */
+        self->eof = 1;
+        if (self->queued) {
+            Io_Modify((Watcher *)self, EV_WRITE);
+        }
+        else {
+            ev_io_stop(loop, io);
+        }
+        generation = self->generation;
+        Stream_InvokeRest(self, loop);
+        if (self->generation == generation) {
+            Stream_Invoke(self, loop, PyBytes_FromStringAndSize(NULL, 0));
+        }
+    }
+}
+
+
+/* set the Stream */
+int
+Stream_Set(Stream *self, PyObject *fd)
+{
+    if (Io_Set((Watcher *)self, fd, EV_READ)) {
+        return -1;
+    }
+    PYEV_BEGIN_LOCK(((Watcher *)self)->loop);
+    Stream_ClearQueue(self);
+    self->start = self->end = self->scanned = 0;
+    self->error = self->eof = 0;
+    self->generation++;
+    PYEV_END_LOCK();
+    return 0;
+}
+
+
+/* set the Stream buffer size */
+int
+Stream_SetBufsize(Stream *self, Py_ssize_t bufsize)
+{
+    if (bufsize <= 0) {
+        PyErr_SetString(PyExc_ValueError, "'bufsize' must be positive");
+        return -1;
+    }
+    self->bufsize = bufsize;
+    return 0;
+}
+
+
+/* set the Stream framing */
+int
+Stream_SetFraming(Stream *self, PyObject *delimiter, int prefix,
+                  const char *byteorder, Py_ssize_t max_frame)
+{
+    int little_endian;
+
+    if (delimiter == Py_None) {
+        delimiter = NULL;
+    }
+    else if (!PyBytes_Check(delimiter) || !PyBytes_GET_SIZE(delimiter)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "'delimiter' must be a non-empty bytes or None");
+        return -1;
+    }
+    if (prefix != 0 && prefix != 1 && prefix != 2 && prefix != 4 &&
+        prefix != 8) {
+        PyErr_SetString(PyExc_ValueError, "'prefix' must be 0, 1, 2, 4 or 8");
+        return -1;
+    }
+    if (delimiter && prefix) {
+        PyErr_SetString(PyExc_ValueError,
+                        "'delimiter' and 'prefix' are mutually exclusive");
+        return -1;
+    }
+    if (!strcmp(byteorder, "little")) {
+        little_endian = 1;
+    }
+    else if (!strcmp(byteorder, "big")) {
+        little_endian = 0;
+    }
+    else {
+        PyErr_SetString(PyExc_ValueError,
+                        "'byteorder' must be either 'little' or 'big'");
+        return -1;
+    }
+    if (max_frame <= 0) {
+        PyErr_SetString(PyExc_ValueError, "'max_frame' must be positive");
+        return -1;
+    }
+    PyObject *tmp = self->delimiter;
+    Py_XINCREF(delimiter);
+    PYEV_BEGIN_LOCK(((Watcher *)self)->loop);
+    self->delimiter = delimiter;
+    self->prefix = prefix;
+    self->little_endian = little_endian;
+    self->max_frame = max_frame;
+    self->scanned = 0;
+    PYEV_END_LOCK();
+    Py_XDECREF(tmp);
+    return 0;
+}
+
+
+/* write data, what can't be written right away is queued (the queue then
+   owns view) */
+int
+Stream_Write(Stream *self, Py_buffer *view)
+{
+    int fd = ((ev_io *)((Watcher *)self)->watcher)->fd;
+    Py_ssize_t result = 0;
+
+    if (!ev_is_active(((Watcher *)self)->watcher)) {
+        /* nothing would ever flush the queue */
+        PyBuffer_Release(view);
+        PyErr_SetString(Error, "cannot write to a Stream while it is stopped");
+        return -1;
+    }
+    if (self->queue_head == self->queue_tail) {
+        /* nothing queued, try to write directly */
+        do {
+            result = write(fd, view->buf, view->len);
+        } while (result < 0 && errno == EINTR);
+        if (result < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                PyBuffer_Release(view);
+                PyErr_SetFromErrno(PyExc_OSError);
+                return -1;
+            }
+            result = 0;
+        }
+        if (result == view->len) {
+            PyBuffer_Release(view);
+            return 0;
+        }
+    }
+    if (Stream_Enqueue(self, view, result)) {
+        PyBuffer_Release(view);
+        return -1;
+    }
+    return 0;
+}
+
+
+/*******************************************************************************
+* StreamType
+*******************************************************************************/
+
+/* StreamType.tp_doc */
+PyDoc_STRVAR(Stream_tp_doc,
+"Stream(fd, loop, callback[, data=None, priority=0, bufsize=8192])");
+
+
+/* StreamType.tp_dealloc */
+static void
+Stream_tp_dealloc(Stream *self)
+{
+    Py_CLEAR(self->buffer);
+    Py_CLEAR(self->delimiter);
+    if (self->queue) {
+        Stream_ClearQueue(self);
+        PyMem_Free(self->queue);
+        self->queue = NULL;
+    }
+    IoType.tp_dealloc((PyObject *)self);
+}
+
+
+/* Stream.set(fd) */
+PyDoc_STRVAR(Stream_set_doc,
+"set(fd)");
+
+static PyObject *
+Stream_set(Stream *self, PyObject *args)
+{
+    PyObject *fd;
+
+    PYEV_WATCHER_SET((Watcher *)self);
+    if (!PyArg_ParseTuple(args, "O:set", &fd)) {
+        return NULL;
+    }
+    if (Stream_Set(self, fd)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Stream.write(data) */
+PyDoc_STRVAR(Stream_write_doc,
+"write(data)");
+
+static PyObject *
+Stream_write(Stream *self, PyObject *args)
+{
+    Py_buffer view;
+    int result;
+
+    if (!PyArg_ParseTuple(args, PYEV_BUFFER_FORMAT ":write", &view)) {
+        return NULL;
+    }
+    PYEV_BEGIN_LOCK(((Watcher *)self)->loop);
+    result = Stream_Write(self, &view);
+    PYEV_END_LOCK();
+    if (result) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* Stream.set_framing([delimiter=None, prefix=0, byteorder='big',
+                      max_frame=16777216]) */
+PyDoc_STRVAR(Stream_set_framing_doc,
+"set_framing([delimiter=None, prefix=0, byteorder='big', max_frame=16777216])");
+
+static PyObject *
+Stream_set_framing(Stream *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *delimiter = Py_None;
+    int prefix = 0;
+    const char *byteorder = "big";
+    Py_ssize_t max_frame = PYEV_STREAM_MAX_FRAME;
+
+    static char *kwlist[] = {"delimiter", "prefix", "byteorder", "max_frame",
+                             NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|Oisn:set_framing", kwlist,
+            &delimiter, &prefix, &byteorder, &max_frame)) {
+        return NULL;
+    }
+    if (Stream_SetFraming(self, delimiter, prefix, byteorder, max_frame)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+/* StreamType.tp_methods */
+static PyMethodDef Stream_tp_methods[] = {
+    {"set", (PyCFunction)Stream_set,
+     METH_VARARGS, Stream_set_doc},
+    {"write", (PyCFunction)Stream_write,
+     METH_VARARGS, Stream_write_doc},
+    {"set_framing", (PyCFunction)Stream_set_framing,
+     METH_VARARGS | METH_KEYWORDS, Stream_set_framing_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* StreamType.tp_members */
+static PyMemberDef Stream_tp_members[] = {
+    {"queued", T_PYSSIZET, offsetof(Stream, queued), READONLY, NULL},
+    {"error", T_INT, offsetof(Stream, error), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* Stream.buffered */
+static PyObject *
+Stream_buffered_get(Stream *self, void *closure)
+{
+    Py_ssize_t buffered;
+
+    PYEV_BEGIN_LOCK(((Watcher *)self)->loop);
+    buffered = self->end - self->start;
+    PYEV_END_LOCK();
+    return PyInt_FromSsize_t(buffered);
+}
+
+
+/* Stream.bufsize */
+static PyObject *
+Stream_bufsize_get(Stream *self, void *closure)
+{
+    return PyInt_FromSsize_t(self->bufsize);
+}
+
+static int
+Stream_bufsize_set(Stream *self, PyObject *value, void *closure)
+{
+    PYEV_PROTECTED_ATTRIBUTE(value);
+    Py_ssize_t bufsize = PyNumber_AsSsize_t(value, PyExc_OverflowError);
+    if (bufsize == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    return Stream_SetBufsize(self, bufsize);
+}
+
+
+/* StreamType.tp_getsets */
+static PyGetSetDef Stream_tp_getsets[] = {
+    {"buffered", (getter)Stream_buffered_get,
+     Readonly_attribute_set, NULL, NULL},
+    {"bufsize", (getter)Stream_bufsize_get,
+     (setter)Stream_bufsize_set, NULL, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* StreamType.tp_init */
+static int
+Stream_tp_init(Stream *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *fd;
+    Loop *loop;
+    PyObject *callback, *data = NULL;
+    int priority = 0;
+    Py_ssize_t bufsize = PYEV_STREAM_BUFSIZE;
+
+    static char *kwlist[] = {"fd",
+                             "loop", "callback", "data", "priority",
+                             "bufsize", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO!O|Oin:__init__", kwlist,
+            &fd,
+            &LoopType, &loop, &callback, &data, &priority,
+            &bufsize)) {
+        return -1;
+    }
+    if (Watcher_Init((Watcher *)self, loop, callback, data, priority) ||
+        Stream_SetBufsize(self, bufsize)) {
+        return -1;
+    }
+    return Stream_Set(self, fd);
+}
+
+
+/* StreamType.tp_new */
+static PyObject *
+Stream_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Stream *self = (Stream *)IoType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    ev_set_cb((ev_io *)((Watcher *)self)->watcher, Stream_Callback);
+    self->bufsize = PYEV_STREAM_BUFSIZE;
+    self->max_frame = PYEV_STREAM_MAX_FRAME;
+    return (PyObject *)self;
+}
+
+
+/* StreamType */
+static PyTypeObject StreamType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.Stream",                            /*tp_name*/
+    PYEV_WATCHER_SIZE(Stream, ev_io),         /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)Stream_tp_dealloc,            /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    Stream_tp_doc,                            /*tp_doc*/
+    0,                                        /*tp_traverse*/
+    0,                                        /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    Stream_tp_methods,                        /*tp_methods*/
+    Stream_tp_members,                        /*tp_members*/
+    Stream_tp_getsets,                        /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    (initproc)Stream_tp_init,                 /*tp_init*/
+    0,                                        /*tp_alloc*/
+    Stream_tp_new,                            /*tp_new*/
+};
@@ -0,0 +1,498 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+/* the current exception, normalized, to be thrown into a coroutine */
+PyObject *
+Task_FetchError(void)
+{
+    PyObject *type, *value, *traceback;
+
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+#if PY_MAJOR_VERSION >= 3
+    if (value && traceback) {
+        PyException_SetTraceback(value, traceback);
+    }
+#endif
+    Py_XDECREF(type);
+    Py_XDECREF(traceback);
+    return value;
+}
+
+
+/* the watcher of what we wait for (a Wait or a Watcher) */
+Watcher *
+Task_Watcher(Task *self)
+{
+    if (Py_TYPE(self->waiting) == &WaitType) {
+        return ((Wait *)self->waiting)->watcher;
+    }
+    return (Watcher *)self->waiting;
+}
+
+
+/* start a watcher yielded by the coroutine, we become its callback */
+int
+Task_Watch(Task *self, Watcher *watcher)
+{
+    if (ev_cb(watcher->watcher) != Watcher_Callback) {
+        PyErr_Format(PyExc_TypeError, "a Task can't wait for a '%.200s'",
+                     Py_TYPE(watcher)->tp_name);
+        return -1;
+    }
+    if (watcher->loop != self->loop) {
+        PyErr_SetString(Error, "this watcher belongs to another loop");
+        return -1;
+    }
+    if (Watcher_IsActive(watcher)) {
+        PyErr_SetString(Error, "this watcher is already active");
+        return -1;
+    }
+    if (watcher->callback != (PyObject *)self) {
+        /* given back when we stop waiting (see Task_Unwatch) */
+        PyObject *previous = watcher->callback;
+        Py_INCREF(previous);
+        if (Watcher_SetCallback(watcher, (PyObject *)self)) {
+            Py_DECREF(previous);
+            return -1;
+        }
+        Py_XSETREF(self->previous, previous);
+    }
+    Watcher_Start(watcher);
+    return 0;
+}
+
+
+/* stop the watcher we waited for, and give it its callback back */
+void
+Task_Unwatch(Task *self, Watcher *watcher)
+{
+    PyObject *previous = self->previous;
+
+    Watcher_Stop(watcher);
+    if (!previous) {
+        return;
+    }
+    self->previous = NULL;
+    if (watcher->callback != (PyObject *)self) {
+        /* replaced while we were waiting, keep that one */
+        Py_DECREF(previous);
+        return;
+    }
+    PYEV_BEGIN_LOCK(watcher->loop);
+    watcher->callback = previous;
+    PYEV_END_LOCK();
+    Py_DECREF(self);
+}
+
+
+/* the coroutine yielded result, wait for it.
+   None is a plain yield, the task goes back to the ready queue */
+int
+Task_Wait(Task *self, PyObject *result)
+{
+    if (result == Py_None) {
+        return Loop_Schedule(self->loop, self);
+    }
+    if (Py_TYPE(result) == &WaitType) {
+        if (Wait_Start((Wait *)result, self->loop, (PyObject *)self)) {
+            return -1;
+        }
+    }
+    else if (PyObject_TypeCheck(result, &WatcherType)) {
+        if (Task_Watch(self, (Watcher *)result)) {
+            return -1;
+        }
+    }
+    else {
+        PyErr_Format(PyExc_TypeError,
+                     "a Task can only wait for a Wait or a Watcher, "
+                     "not '%.200s'", Py_TYPE(result)->tp_name);
+        return -1;
+    }
+    Py_INCREF(result);
+    self->waiting = result;
+    /* the loop holds waiting tasks */
+    Py_INCREF(self);
+    return 0;
+}
+
+
+/* the coroutine is done, keep what it returned or raised.
+   returns -1 with the exception raised by the coroutine set */
+int
+Task_Done(Task *self, PyObject *result)
+{
+    PyObject *type, *value, *traceback;
+
+    self->done = 1;
+    if (result) {
+        self->result = result;
+        return 0;
+    }
+    if (PyErr_ExceptionMatches(PyExc_StopIteration)) {
+        PyErr_Fetch(&type, &value, &traceback);
+        PyErr_NormalizeException(&type, &value, &traceback);
+#if PY_MAJOR_VERSION >= 3
+        if (value) {
+            result = ((PyStopIterationObject *)value)->value;
+        }
+#else
+        /* raise StopIteration(result) */
+        if (value &&
+            PyTuple_GET_SIZE(((PyBaseExceptionObject *)value)->args)) {
+            result =
+                PyTuple_GET_ITEM(((PyBaseExceptionObject *)value)->args, 0);
+        }
+#endif
+        self->result = result ? result : Py_None;
+        Py_INCREF(self->result);
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+        return 0;
+    }
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+#if PY_MAJOR_VERSION >= 3
+    if (value && traceback) {
+        PyException_SetTraceback(value, traceback);
+    }
+#endif
+    Py_XINCREF(value);
+    self->error = value;
+    PyErr_Restore(type, value, traceback);
+    return -1;
+}
+
+
+/* run the coroutine until it waits (or is done), sending value into it (None
+   if NULL), or throwing error (a reference we steal) if not NULL.
+   returns -1 with the exception raised by the coroutine set */
+int
+Task_Step(Task *self, PyObject *value, PyObject *error)
+{
+    PyObject *result;
+
+    for (;;) {
+        self->running = 1;
+        if (error) {
+            result = PyObject_CallMethod(self->coro, "throw", "O", error);
+            Py_DECREF(error);
+        }
+        else {
+#if PY_VERSION_HEX >= 0x030A0000
+            if (PyIter_Send(self->coro, value ? value : Py_None,
+                            &result) == PYGEN_RETURN) {
+                self->running = 0;
+                return Task_Done(self, result);
+            }
+#else
+            result = PyObject_CallMethod(self->coro, "send", "O",
+                                         value ? value : Py_None);
+#endif
+        }
+        self->running = 0;
+        if (!result) {
+            return Task_Done(self, NULL);
+        }
+        if (!Task_Wait(self, result)) {
+            Py_DECREF(result);
+            return 0;
+        }
+        Py_DECREF(result);
+        /* the error goes to the coroutine */
+        value = NULL;
+        if (!(error = Task_FetchError())) {
+            return Task_Done(self, NULL);
+        }
+    }
+}
+
+
+/* create a Task, ready to run coro */
+PyObject *
+Task_New(Loop *loop, PyObject *coro)
+{
+    Task *self;
+
+#if PY_VERSION_HEX >= 0x03050000
+    if (!PyGen_Check(coro) && !PyCoro_CheckExact(coro) &&
+#else
+    if (!PyGen_Check(coro) &&
+#endif
+        !PyObject_HasAttrString(coro, "send")) {
+        PyErr_SetString(PyExc_TypeError,
+                        "a coroutine or a generator is required");
+        return NULL;
+    }
+    self = PyObject_GC_New(Task, &TaskType);
+    if (!self) {
+        return NULL;
+    }
+    self->next = NULL;
+    Py_INCREF(loop);
+    self->loop = loop;
+    Py_INCREF(coro);
+    self->coro = coro;
+    self->waiting = NULL;
+    self->previous = NULL;
+    self->result = NULL;
+    self->error = NULL;
+    self->running = 0;
+    self->done = 0;
+    self->cancelled = 0;
+    PyObject_GC_Track(self);
+    if (Loop_Schedule(loop, self)) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject *)self;
+}
+
+
+/* run a task taken from the ready queue (we get its reference) */
+void
+Task_Run(Task *self)
+{
+    if (!self->done && Task_Step(self, NULL, NULL)) {
+        Loop_WarnOrStop(self->loop, (PyObject *)self);
+    }
+    Py_DECREF(self);
+}
+
+
+/* the watcher we wait for fired, resume the coroutine, sending it revents
+   (None for a Wait) or throwing it the error of the watcher.
+   returns -1 if we weren't waiting for watcher */
+int
+Task_Resume(Task *self, Watcher *watcher, int revents)
+{
+    PyObject *waiting = self->waiting, *value = NULL, *error = NULL;
+    int wait;
+
+    if (!waiting || Task_Watcher(self) != watcher) {
+        return -1;
+    }
+    wait = (Py_TYPE(waiting) == &WaitType);
+    Task_Unwatch(self, watcher);
+    self->waiting = NULL;
+    if (revents & EV_ERROR) {
+        error = Task_FetchError();
+    }
+    else if (wait) {
+        ((Wait *)waiting)->fired = 1;
+    }
+    else if (!(value = Revents_FromInt(revents))) {
+        error = Task_FetchError();
+    }
+    if (Task_Step(self, value, error)) {
+        Loop_WarnOrStop(self->loop, (PyObject *)self);
+    }
+    if (wait) {
+        /* a generator yielding the Wait doesn't iterate it */
+        ((Wait *)waiting)->fired = 0;
+    }
+    Py_XDECREF(value);
+    Py_DECREF(waiting);
+    Py_DECREF(self);
+    return 0;
+}
+
+
+/*******************************************************************************
+* TaskType
+*******************************************************************************/
+
+/* TaskType.tp_doc */
+PyDoc_STRVAR(Task_tp_doc,
+"Task");
+
+
+/* TaskType.tp_traverse */
+static int
+Task_tp_traverse(Task *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->loop);
+    Py_VISIT(self->coro);
+    Py_VISIT(self->waiting);
+    Py_VISIT(self->previous);
+    Py_VISIT(self->result);
+    Py_VISIT(self->error);
+    return 0;
+}
+
+
+/* TaskType.tp_clear */
+static int
+Task_tp_clear(Task *self)
+{
+    Py_CLEAR(self->waiting);
+    Py_CLEAR(self->previous);
+    Py_CLEAR(self->result);
+    Py_CLEAR(self->error);
+    Py_CLEAR(self->coro);
+    Py_CLEAR(self->loop);
+    return 0;
+}
+
+
+/* TaskType.tp_dealloc */
+static void
+Task_tp_dealloc(Task *self)
+{
+    PyObject_GC_UnTrack(self);
+    Task_tp_clear(self);
+    PyObject_GC_Del(self);
+}
+
+
+/* TaskType.tp_call, we are the callback of the watchers we wait for */
+static PyObject *
+Task_tp_call(Task *self, PyObject *args, PyObject *kwargs)
+{
+    Watcher *watcher;
+    int revents;
+
+    if (!PyArg_ParseTuple(args, "O!i:__call__",
+                          &WatcherType, &watcher, &revents)) {
+        return NULL;
+    }
+    Task_Resume(self, watcher, revents);
+    Py_RETURN_NONE;
+}
+
+
+/* Task.done() -> bool */
+PyDoc_STRVAR(Task_done_doc,
+"done() -> bool");
+
+static PyObject *
+Task_done(Task *self)
+{
+    return PyBool_FromLong(self->done);
+}
+
+
+/* Task.result() -> object */
+PyDoc_STRVAR(Task_result_doc,
+"result() -> object");
+
+static PyObject *
+Task_result(Task *self)
+{
+    if (self->cancelled) {
+        PyErr_SetString(Error, "the Task was cancelled");
+        return NULL;
+    }
+    if (!self->done) {
+        PyErr_SetString(Error, "the Task is not done");
+        return NULL;
+    }
+    if (self->error) {
+        PyErr_SetObject((PyObject *)Py_TYPE(self->error), self->error);
+        return NULL;
+    }
+    Py_INCREF(self->result);
+    return self->result;
+}
+
+
+/* Task.cancel() -> bool */
+PyDoc_STRVAR(Task_cancel_doc,
+"cancel() -> bool");
+
+static PyObject *
+Task_cancel(Task *self)
+{
+    PyObject *waiting = self->waiting, *result;
+
+    if (self->done) {
+        return PyBool_FromLong(0);
+    }
+    if (self->running) {
+        PyErr_SetString(Error, "a running Task can't be cancelled");
+        return NULL;
+    }
+    /* a queued task is skipped when its turn comes */
+    self->done = self->cancelled = 1;
+    if (waiting) {
+        Task_Unwatch(self, Task_Watcher(self));
+        self->waiting = NULL;
+    }
+    result = PyObject_CallMethod(self->coro, "close", NULL);
+    if (waiting) {
+        Py_DECREF(waiting);
+        /* the reference the loop held */
+        Py_DECREF(self);
+    }
+    if (!result) {
+        return NULL;
+    }
+    Py_DECREF(result);
+    return PyBool_FromLong(1);
+}
+
+
+/* TaskType.tp_methods */
+static PyMethodDef Task_tp_methods[] = {
+    {"done", (PyCFunction)Task_done,
+     METH_NOARGS, Task_done_doc},
+    {"result", (PyCFunction)Task_result,
+     METH_NOARGS, Task_result_doc},
+    {"cancel", (PyCFunction)Task_cancel,
+     METH_NOARGS, Task_cancel_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* TaskType.tp_members */
+static PyMemberDef Task_tp_members[] = {
+    {"loop", T_OBJECT_EX, offsetof(Task, loop), READONLY, NULL},
+    {"coro", T_OBJECT_EX, offsetof(Task, coro), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* TaskType */
+static PyTypeObject TaskType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.Task",                              /*tp_name*/
+    sizeof(Task),                             /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)Task_tp_dealloc,              /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    (ternaryfunc)Task_tp_call,                /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    Task_tp_doc,                              /*tp_doc*/
+    (traverseproc)Task_tp_traverse,           /*tp_traverse*/
+    (inquiry)Task_tp_clear,                   /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    Task_tp_methods,                          /*tp_methods*/
+    Task_tp_members,                          /*tp_members*/
+    0,                                        /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    0,                                        /*tp_init*/
+    0,                                        /*tp_alloc*/
+    0,                                        /*tp_new*/
+};
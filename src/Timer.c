@@ -127,11 +127,15 @@ Timer_tp_init(Watcher *self, PyObject *args, PyObject *kwargs)
 }
 
 
+/* TimerType operations */
+PYEV_WATCHER_OPS(ev_timer, EV_TIMER, 0);
+
+
 /* TimerType.tp_new */
 static PyObject *
 Timer_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
-    return (PyObject *)Watcher_New(type, EV_TIMER, sizeof(ev_timer));
+    return (PyObject *)Watcher_New(type, &ev_timer_ops);
 }
 
 
@@ -139,7 +143,7 @@ Timer_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static PyTypeObject TimerType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyev.Timer",                             /*tp_name*/
-    sizeof(Watcher),                          /*tp_basicsize*/
+    PYEV_WATCHER_SIZE(Watcher, ev_timer),     /*tp_basicsize*/
     0,                                        /*tp_itemsize*/
     0,                                        /*tp_dealloc*/
     0,                                        /*tp_print*/
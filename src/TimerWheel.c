@@ -0,0 +1,616 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+#define PYEV_WHEEL_BITS 8
+#define PYEV_WHEEL_SLOTS (1 << PYEV_WHEEL_BITS)
+#define PYEV_WHEEL_MASK (PYEV_WHEEL_SLOTS - 1)
+#define PYEV_WHEEL_NIL UINT_MAX
+/* the farthest timeout the 4 levels can hold, in ticks */
+#define PYEV_WHEEL_MAX 0xffffffffULL
+
+#define PYEV_WHEEL_INDEX(id) ((unsigned int)((id) & 0xffffffffULL))
+#define PYEV_WHEEL_GENERATION(id) ((unsigned int)((id) >> 32))
+#define PYEV_WHEEL_ID(i, e) \
+    (((unsigned PY_LONG_LONG)(e)->generation << 32) | (i))
+
+
+/* the tick corresponding to now */
+unsigned PY_LONG_LONG
+TimerWheel_Now(TimerWheel *self)
+{
+    double now = ev_now(((Watcher *)self)->loop->loop) - self->origin;
+    return (now > 0.0) ? (unsigned PY_LONG_LONG)(now / self->resolution) : 0;
+}
+
+
+/* convert a timeout to a number of ticks (rounded up, at least 1) */
+int
+TimerWheel_Ticks(TimerWheel *self, double timeout,
+                 unsigned PY_LONG_LONG *ticks)
+{
+    double result;
+
+    if (timeout < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "'timeout' must be positive or 0");
+        return -1;
+    }
+    result = ceil(timeout / self->resolution);
+    if (result < 1.0) {
+        result = 1.0;
+    }
+    *ticks = (result > (double)PYEV_WHEEL_MAX) ?
+             PYEV_WHEEL_MAX : (unsigned PY_LONG_LONG)result;
+    return 0;
+}
+
+
+/* put an entry in the slot matching its expiry */
+void
+TimerWheel_Link(TimerWheel *self, unsigned int index)
+{
+    TimerWheelEntry *entry = &self->entries[index];
+    unsigned PY_LONG_LONG delta;
+    unsigned int slot;
+
+    if (entry->expires < self->ticks) {
+        /* already late, expire on the next tick */
+        slot = self->ticks & PYEV_WHEEL_MASK;
+    }
+    else {
+        delta = entry->expires - self->ticks;
+        if (delta < (1ULL << PYEV_WHEEL_BITS)) {
+            slot = entry->expires & PYEV_WHEEL_MASK;
+        }
+        else if (delta < (1ULL << (2 * PYEV_WHEEL_BITS))) {
+            slot = PYEV_WHEEL_SLOTS +
+                   ((entry->expires >> PYEV_WHEEL_BITS) & PYEV_WHEEL_MASK);
+        }
+        else if (delta < (1ULL << (3 * PYEV_WHEEL_BITS))) {
+            slot = 2 * PYEV_WHEEL_SLOTS +
+                   ((entry->expires >> (2 * PYEV_WHEEL_BITS)) &
+                    PYEV_WHEEL_MASK);
+        }
+        else {
+            if (delta > PYEV_WHEEL_MAX) {
+                entry->expires = self->ticks + PYEV_WHEEL_MAX;
+            }
+            slot = 3 * PYEV_WHEEL_SLOTS +
+                   ((entry->expires >> (3 * PYEV_WHEEL_BITS)) &
+                    PYEV_WHEEL_MASK);
+        }
+    }
+    entry->slot = slot;
+    entry->prev = PYEV_WHEEL_NIL;
+    entry->next = self->slots[slot];
+    if (entry->next != PYEV_WHEEL_NIL) {
+        self->entries[entry->next].prev = index;
+    }
+    self->slots[slot] = index;
+}
+
+
+/* take an entry out of its slot */
+void
+TimerWheel_Unlink(TimerWheel *self, unsigned int index)
+{
+    TimerWheelEntry *entry = &self->entries[index];
+
+    if (entry->prev != PYEV_WHEEL_NIL) {
+        self->entries[entry->prev].next = entry->next;
+    }
+    else {
+        self->slots[entry->slot] = entry->next;
+    }
+    if (entry->next != PYEV_WHEEL_NIL) {
+        self->entries[entry->next].prev = entry->prev;
+    }
+}
+
+
+/* the timer only runs while there are timeouts, stop it once the last one is
+   gone */
+void
+TimerWheel_Sleep(TimerWheel *self)
+{
+    ev_timer *timer = (ev_timer *)((Watcher *)self)->watcher;
+
+    if (ev_is_active(timer)) {
+        ev_timer_stop(((Watcher *)self)->loop->loop, timer);
+    }
+}
+
+
+/* and restart it with the first one, the ticks elapsed in between had
+   nothing to expire */
+void
+TimerWheel_Wake(TimerWheel *self)
+{
+    self->ticks = TimerWheel_Now(self) + 1;
+    if (self->started) {
+        ev_timer_again(((Watcher *)self)->loop->loop,
+                       (ev_timer *)((Watcher *)self)->watcher);
+    }
+}
+
+
+/* release an entry, its id becomes invalid */
+void
+TimerWheel_Release(TimerWheel *self, unsigned int index)
+{
+    TimerWheelEntry *entry = &self->entries[index];
+    PyObject *key = entry->key;
+
+    entry->key = NULL;
+    entry->generation++;
+    entry->next = self->free;
+    self->free = index;
+    self->count--;
+    if (!self->count) {
+        TimerWheel_Sleep(self);
+    }
+    /* last, this can run arbitrary code */
+    Py_DECREF(key);
+}
+
+
+/* find the entry for id, returns PYEV_WHEEL_NIL if it is gone */
+unsigned int
+TimerWheel_Find(TimerWheel *self, PyObject *pyid)
+{
+    unsigned PY_LONG_LONG id = PyLong_AsUnsignedLongLongMask(pyid);
+    unsigned int index = PYEV_WHEEL_INDEX(id);
+
+    if ((id == (unsigned PY_LONG_LONG)-1 && PyErr_Occurred()) ||
+        index >= self->size || !self->entries[index].key ||
+        self->entries[index].generation != PYEV_WHEEL_GENERATION(id)) {
+        return PYEV_WHEEL_NIL;
+    }
+    return index;
+}
+
+
+/* get a free entry, growing the table if needed */
+unsigned int
+TimerWheel_Allocate(TimerWheel *self)
+{
+    TimerWheelEntry *entries;
+    unsigned int index, size;
+
+    if (self->free == PYEV_WHEEL_NIL) {
+        if (self->size >= PYEV_WHEEL_NIL / 2) {
+            PyErr_SetString(PyExc_OverflowError, "too many timeouts");
+            return PYEV_WHEEL_NIL;
+        }
+        size = self->size ? self->size * 2 : 64;
+        entries = PyMem_Realloc(self->entries, size * sizeof(TimerWheelEntry));
+        if (!entries) {
+            PyErr_NoMemory();
+            return PYEV_WHEEL_NIL;
+        }
+        for (index = size; index-- > self->size; ) {
+            entries[index].key = NULL;
+            entries[index].generation = 0;
+            entries[index].next = self->free;
+            self->free = index;
+        }
+        self->entries = entries;
+        self->size = size;
+    }
+    index = self->free;
+    self->free = self->entries[index].next;
+    self->count++;
+    return index;
+}
+
+
+/* move the entries of a slot of an upper level down */
+unsigned int
+TimerWheel_Cascade(TimerWheel *self, int level, unsigned int slot)
+{
+    unsigned int index = self->slots[level * PYEV_WHEEL_SLOTS + slot], next;
+
+    self->slots[level * PYEV_WHEEL_SLOTS + slot] = PYEV_WHEEL_NIL;
+    while (index != PYEV_WHEEL_NIL) {
+        next = self->entries[index].next;
+        TimerWheel_Link(self, index);
+        index = next;
+    }
+    return slot;
+}
+
+
+/* process every tick up to (and including) target, collecting keys */
+int
+TimerWheel_Advance(TimerWheel *self, unsigned PY_LONG_LONG target,
+                   PyObject *expired)
+{
+    unsigned int slot, index, next;
+    int result = 0;
+
+    while (self->ticks <= target) {
+        if (!self->count) {
+            /* nothing to expire, just catch up */
+            self->ticks = target + 1;
+            break;
+        }
+        slot = self->ticks & PYEV_WHEEL_MASK;
+        if (!slot &&
+            !TimerWheel_Cascade(self, 1,
+                (self->ticks >> PYEV_WHEEL_BITS) & PYEV_WHEEL_MASK) &&
+            !TimerWheel_Cascade(self, 2,
+                (self->ticks >> (2 * PYEV_WHEEL_BITS)) & PYEV_WHEEL_MASK)) {
+            TimerWheel_Cascade(self, 3,
+                (self->ticks >> (3 * PYEV_WHEEL_BITS)) & PYEV_WHEEL_MASK);
+        }
+        self->ticks++;
+        index = self->slots[slot];
+        self->slots[slot] = PYEV_WHEEL_NIL;
+        while (index != PYEV_WHEEL_NIL) {
+            next = self->entries[index].next;
+            if (PyList_Append(expired, self->entries[index].key)) {
+                result = -1;
+            }
+            TimerWheel_Release(self, index);
+            index = next;
+        }
+    }
+    return result;
+}
+
+
+/* drop all the timeouts */
+void
+TimerWheel_Clear(TimerWheel *self)
+{
+    unsigned int index;
+
+    for (index = 0; index < self->size; index++) {
+        if (self->entries[index].key) {
+            TimerWheel_Release(self, index);
+        }
+    }
+    for (index = 0; index < 4 * PYEV_WHEEL_SLOTS; index++) {
+        self->slots[index] = PYEV_WHEEL_NIL;
+    }
+}
+
+
+/* (re)schedule an entry */
+void
+TimerWheel_Schedule(TimerWheel *self, unsigned int index)
+{
+    TimerWheelEntry *entry = &self->entries[index];
+
+    /* + 1: the current tick is (partly) elapsed, never expire early */
+    entry->expires = TimerWheel_Now(self) + entry->timeout + 1;
+    TimerWheel_Link(self, index);
+}
+
+
+/* timerwheel timer callback */
+static void
+TimerWheel_Callback(struct ev_loop *loop, ev_timer *timer, int revents)
+{
+    TimerWheel *self = timer->data;
+    PyObject *expired, *pyresult;
+
+    if (revents & EV_ERROR) {
+        Watcher_Callback(loop, (ev_watcher *)timer, revents);
+        return;
+    }
+    if (!self->count) {
+        self->ticks = TimerWheel_Now(self) + 1;
+        return;
+    }
+    expired = PyList_New(0);
+    if (!expired) {
+        PYEV_LOOP_EXIT(loop);
+        return;
+    }
+    if (TimerWheel_Advance(self, TimerWheel_Now(self), expired)) {
+        PYEV_LOOP_EXIT(loop);
+    }
+    else if (PyList_GET_SIZE(expired)) {
+        Py_INCREF(self);
+        pyresult = Callback_Invoke(((Watcher *)self)->callback,
+                                   (PyObject *)self, expired);
+        if (!pyresult) {
+            Loop_WarnOrStop(ev_userdata(loop), ((Watcher *)self)->callback);
+        }
+        else {
+            Py_DECREF(pyresult);
+        }
+        Py_DECREF(self);
+    }
+    Py_DECREF(expired);
+}
+
+
+/* set the TimerWheel */
+int
+TimerWheel_Set(TimerWheel *self, double resolution)
+{
+    if (resolution <= 0.0) {
+        PyErr_SetString(PyExc_ValueError, "'resolution' must be positive");
+        return -1;
+    }
+    TimerWheel_Clear(self);
+    self->resolution = resolution;
+    self->origin = ev_now(((Watcher *)self)->loop->loop);
+    self->ticks = 0;
+    ev_timer_set((ev_timer *)((Watcher *)self)->watcher, resolution,
+                 resolution);
+    return 0;
+}
+
+
+/*******************************************************************************
+* TimerWheelType
+*******************************************************************************/
+
+/* TimerWheelType.tp_doc */
+PyDoc_STRVAR(TimerWheel_tp_doc,
+"TimerWheel(resolution, loop, callback[, data=None, priority=0])");
+
+
+/* TimerWheelType.tp_traverse */
+static int
+TimerWheel_tp_traverse(TimerWheel *self, visitproc visit, void *arg)
+{
+    unsigned int index;
+
+    for (index = 0; index < self->size; index++) {
+        Py_VISIT(self->entries[index].key);
+    }
+    return Watcher_tp_traverse((Watcher *)self, visit, arg);
+}
+
+
+/* TimerWheelType.tp_clear */
+static int
+TimerWheel_tp_clear(TimerWheel *self)
+{
+    TimerWheel_Clear(self);
+    return Watcher_tp_clear((Watcher *)self);
+}
+
+
+/* TimerWheelType.tp_dealloc */
+static void
+TimerWheel_tp_dealloc(TimerWheel *self)
+{
+    if (self->entries) {
+        TimerWheel_Clear(self);
+        PyMem_Free(self->entries);
+        self->entries = NULL;
+    }
+    WatcherType.tp_dealloc((PyObject *)self);
+}
+
+
+/* TimerWheel.add(timeout, key) -> int */
+PyDoc_STRVAR(TimerWheel_add_doc,
+"add(timeout, key) -> int");
+
+static PyObject *
+TimerWheel_add(TimerWheel *self, PyObject *args)
+{
+    double timeout;
+    PyObject *key;
+    unsigned PY_LONG_LONG ticks;
+    unsigned int index;
+
+    if (!PyArg_ParseTuple(args, "dO:add", &timeout, &key)) {
+        return NULL;
+    }
+    if (TimerWheel_Ticks(self, timeout, &ticks)) {
+        return NULL;
+    }
+    index = TimerWheel_Allocate(self);
+    if (index == PYEV_WHEEL_NIL) {
+        return NULL;
+    }
+    if (self->count == 1) {
+        TimerWheel_Wake(self);
+    }
+    Py_INCREF(key);
+    self->entries[index].key = key;
+    self->entries[index].timeout = ticks;
+    TimerWheel_Schedule(self, index);
+    return PyLong_FromUnsignedLongLong(
+        PYEV_WHEEL_ID(index, &self->entries[index]));
+}
+
+
+/* TimerWheel.cancel(id) -> bool */
+PyDoc_STRVAR(TimerWheel_cancel_doc,
+"cancel(id) -> bool");
+
+static PyObject *
+TimerWheel_cancel(TimerWheel *self, PyObject *pyid)
+{
+    unsigned int index = TimerWheel_Find(self, pyid);
+
+    if (index == PYEV_WHEEL_NIL) {
+        return PyErr_Occurred() ? NULL : PyBool_FromLong(0);
+    }
+    TimerWheel_Unlink(self, index);
+    TimerWheel_Release(self, index);
+    return PyBool_FromLong(1);
+}
+
+
+/* TimerWheel.touch(id[, timeout]) -> bool */
+PyDoc_STRVAR(TimerWheel_touch_doc,
+"touch(id[, timeout]) -> bool");
+
+static PyObject *
+TimerWheel_touch(TimerWheel *self, PyObject *args)
+{
+    PyObject *pyid;
+    double timeout = -1.0;
+    unsigned PY_LONG_LONG ticks = 0;
+    unsigned int index;
+
+    if (!PyArg_ParseTuple(args, "O|d:touch", &pyid, &timeout)) {
+        return NULL;
+    }
+    if (PyTuple_GET_SIZE(args) > 1 &&
+        TimerWheel_Ticks(self, timeout, &ticks)) {
+        return NULL;
+    }
+    index = TimerWheel_Find(self, pyid);
+    if (index == PYEV_WHEEL_NIL) {
+        return PyErr_Occurred() ? NULL : PyBool_FromLong(0);
+    }
+    if (ticks) {
+        self->entries[index].timeout = ticks;
+    }
+    TimerWheel_Unlink(self, index);
+    TimerWheel_Schedule(self, index);
+    return PyBool_FromLong(1);
+}
+
+
+/* TimerWheelType.tp_methods */
+static PyMethodDef TimerWheel_tp_methods[] = {
+    {"add", (PyCFunction)TimerWheel_add,
+     METH_VARARGS, TimerWheel_add_doc},
+    {"cancel", (PyCFunction)TimerWheel_cancel,
+     METH_O, TimerWheel_cancel_doc},
+    {"touch", (PyCFunction)TimerWheel_touch,
+     METH_VARARGS, TimerWheel_touch_doc},
+    {NULL}  /* Sentinel */
+};
+
+
+/* TimerWheelType.tp_members */
+static PyMemberDef TimerWheel_tp_members[] = {
+    {"resolution", T_DOUBLE, offsetof(TimerWheel, resolution), READONLY, NULL},
+    {"count", T_UINT, offsetof(TimerWheel, count), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* TimerWheelType.tp_init */
+static int
+TimerWheel_tp_init(TimerWheel *self, PyObject *args, PyObject *kwargs)
+{
+    double resolution;
+    Loop *loop;
+    PyObject *callback, *data = NULL;
+    int priority = 0;
+
+    static char *kwlist[] = {"resolution",
+                             "loop", "callback", "data", "priority", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "dO!O|Oi:__init__", kwlist,
+            &resolution,
+            &LoopType, &loop, &callback, &data, &priority)) {
+        return -1;
+    }
+    if (Watcher_Init((Watcher *)self, loop, callback, data, priority)) {
+        return -1;
+    }
+    return TimerWheel_Set(self, resolution);
+}
+
+
+/* TimerWheelType operations, the timer is only started when there are
+   timeouts (see TimerWheel_Sleep/TimerWheel_Wake) */
+static void
+TimerWheel_OpsStart(struct ev_loop *loop, ev_watcher *watcher)
+{
+    TimerWheel *self = watcher->data;
+
+    self->started = 1;
+    if (self->count) {
+        ev_timer_start(loop, (ev_timer *)watcher);
+    }
+}
+
+
+static void
+TimerWheel_OpsStop(struct ev_loop *loop, ev_watcher *watcher)
+{
+    TimerWheel *self = watcher->data;
+
+    self->started = 0;
+    ev_timer_stop(loop, (ev_timer *)watcher);
+}
+
+
+static int
+TimerWheel_OpsIsActive(ev_watcher *watcher)
+{
+    return ((TimerWheel *)watcher->data)->started;
+}
+
+
+static const WatcherOps TimerWheel_ops = {
+    EV_TIMER, sizeof(ev_timer), TimerWheel_OpsStart, TimerWheel_OpsStop,
+    TimerWheel_OpsIsActive, 0
+};
+
+
+/* TimerWheelType.tp_new */
+static PyObject *
+TimerWheel_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    TimerWheel *self = (TimerWheel *)Watcher_New(type, &TimerWheel_ops);
+    unsigned int index;
+
+    if (!self) {
+        return NULL;
+    }
+    ev_set_cb((ev_timer *)((Watcher *)self)->watcher, TimerWheel_Callback);
+    self->free = PYEV_WHEEL_NIL;
+    for (index = 0; index < 4 * PYEV_WHEEL_SLOTS; index++) {
+        self->slots[index] = PYEV_WHEEL_NIL;
+    }
+    return (PyObject *)self;
+}
+
+
+/* TimerWheelType */
+static PyTypeObject TimerWheelType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.TimerWheel",                        /*tp_name*/
+    PYEV_WATCHER_SIZE(TimerWheel, ev_timer),  /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)TimerWheel_tp_dealloc,        /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+    0,                                        /*tp_compare*/
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /*tp_flags*/
+    TimerWheel_tp_doc,                        /*tp_doc*/
+    (traverseproc)TimerWheel_tp_traverse,     /*tp_traverse*/
+    (inquiry)TimerWheel_tp_clear,             /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    0,                                        /*tp_iter*/
+    0,                                        /*tp_iternext*/
+    TimerWheel_tp_methods,                    /*tp_methods*/
+    TimerWheel_tp_members,                    /*tp_members*/
+    0,                                        /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    (initproc)TimerWheel_tp_init,             /*tp_init*/
+    0,                                        /*tp_alloc*/
+    TimerWheel_tp_new,                        /*tp_new*/
+};
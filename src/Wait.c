@@ -0,0 +1,195 @@
+/*******************************************************************************
+* utilities
+*******************************************************************************/
+
+/* create a Wait around a new watcher of type, the callback is set to the Task
+   when it waits */
+Wait *
+Wait_New(Loop *loop, PyTypeObject *type, const WatcherOps *ops)
+{
+    Wait *self = PyObject_GC_New(Wait, &WaitType);
+    if (!self) {
+        return NULL;
+    }
+    self->fired = 0;
+    self->after = 0.0;
+    self->watcher = Watcher_New(type, ops);
+    if (!self->watcher) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    Py_INCREF(loop);
+    self->watcher->loop = loop;
+    Py_INCREF(Py_None);
+    self->watcher->callback = Py_None;
+    PyObject_GC_Track(self);
+    return self;
+}
+
+
+/* start waiting, callback (a Task) is called when the watcher fires */
+int
+Wait_Start(Wait *self, Loop *loop, PyObject *callback)
+{
+    Watcher *watcher = self->watcher;
+
+    if (watcher->loop != loop) {
+        PyErr_SetString(Error, "this Wait belongs to another loop");
+        return -1;
+    }
+    if (Watcher_IsActive(watcher)) {
+        PyErr_SetString(Error, "this Wait is already awaited");
+        return -1;
+    }
+    if (watcher->callback != callback &&
+        Watcher_SetCallback(watcher, callback)) {
+        return -1;
+    }
+    if (watcher->ops == &ev_timer_ops) {
+        /* libev moved the expiry when it stopped the timer */
+        ev_timer_set((ev_timer *)watcher->watcher, self->after, 0.0);
+    }
+    self->fired = 0;
+    Watcher_Start(watcher);
+    return 0;
+}
+
+
+/* wait for events on fd */
+PyObject *
+Wait_NewIo(Loop *loop, PyObject *fd, int events)
+{
+    Wait *self = Wait_New(loop, &IoType, &ev_io_ops);
+    if (self && Io_Set(self->watcher, fd, events)) {
+        Py_CLEAR(self);
+    }
+    return (PyObject *)self;
+}
+
+
+/* wait for after seconds */
+PyObject *
+Wait_NewTimer(Loop *loop, double after)
+{
+    Wait *self = Wait_New(loop, &TimerType, &ev_timer_ops);
+    if (self) {
+        self->after = after;
+    }
+    return (PyObject *)self;
+}
+
+
+/*******************************************************************************
+* WaitType
+*******************************************************************************/
+
+/* WaitType.tp_doc */
+PyDoc_STRVAR(Wait_tp_doc,
+"Wait");
+
+
+/* WaitType.tp_traverse */
+static int
+Wait_tp_traverse(Wait *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->watcher);
+    return 0;
+}
+
+
+/* WaitType.tp_clear */
+static int
+Wait_tp_clear(Wait *self)
+{
+    Py_CLEAR(self->watcher);
+    return 0;
+}
+
+
+/* WaitType.tp_dealloc */
+static void
+Wait_tp_dealloc(Wait *self)
+{
+    PyObject_GC_UnTrack(self);
+    Wait_tp_clear(self);
+    PyObject_GC_Del(self);
+}
+
+
+/* WaitType.tp_iternext
+   the first step suspends the coroutine (yields ourself to the Task), the
+   step after the watcher fired ends the wait */
+static PyObject *
+Wait_tp_iternext(Wait *self)
+{
+    if (self->fired) {
+        self->fired = 0;
+        return NULL;
+    }
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+
+#if PY_VERSION_HEX >= 0x03050000
+/* WaitType.tp_as_async */
+static PyAsyncMethods Wait_tp_as_async = {
+    (unaryfunc)PyObject_SelfIter,             /*am_await*/
+    0,                                        /*am_aiter*/
+    0,                                        /*am_anext*/
+};
+#endif
+
+
+/* WaitType.tp_members */
+static PyMemberDef Wait_tp_members[] = {
+    {"watcher", T_OBJECT_EX, offsetof(Wait, watcher), READONLY, NULL},
+    {NULL}  /* Sentinel */
+};
+
+
+/* WaitType */
+static PyTypeObject WaitType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyev.Wait",                              /*tp_name*/
+    sizeof(Wait),                             /*tp_basicsize*/
+    0,                                        /*tp_itemsize*/
+    (destructor)Wait_tp_dealloc,              /*tp_dealloc*/
+    0,                                        /*tp_print*/
+    0,                                        /*tp_getattr*/
+    0,                                        /*tp_setattr*/
+#if PY_VERSION_HEX >= 0x03050000
+    &Wait_tp_as_async,                        /*tp_as_async*/
+#else
+    0,                                        /*tp_compare*/
+#endif
+    0,                                        /*tp_repr*/
+    0,                                        /*tp_as_number*/
+    0,                                        /*tp_as_sequence*/
+    0,                                        /*tp_as_mapping*/
+    0,                                        /*tp_hash */
+    0,                                        /*tp_call*/
+    0,                                        /*tp_str*/
+    0,                                        /*tp_getattro*/
+    0,                                        /*tp_setattro*/
+    0,                                        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    Wait_tp_doc,                              /*tp_doc*/
+    (traverseproc)Wait_tp_traverse,           /*tp_traverse*/
+    (inquiry)Wait_tp_clear,                   /*tp_clear*/
+    0,                                        /*tp_richcompare*/
+    0,                                        /*tp_weaklistoffset*/
+    PyObject_SelfIter,                        /*tp_iter*/
+    (iternextfunc)Wait_tp_iternext,           /*tp_iternext*/
+    0,                                        /*tp_methods*/
+    Wait_tp_members,                          /*tp_members*/
+    0,                                        /*tp_getsets*/
+    0,                                        /*tp_base*/
+    0,                                        /*tp_dict*/
+    0,                                        /*tp_descr_get*/
+    0,                                        /*tp_descr_set*/
+    0,                                        /*tp_dictoffset*/
+    0,                                        /*tp_init*/
+    0,                                        /*tp_alloc*/
+    0,                                        /*tp_new*/
+};
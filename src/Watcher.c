@@ -5,123 +5,28 @@
 void
 Watcher_Start(Watcher *self)
 {
-    switch (self->type) {
-        case EV_IO:
-            PYEV_WATCHER_START(ev_io, self);
-            break;
-        case EV_TIMER:
-            PYEV_WATCHER_START(ev_timer, self);
-            break;
-#if EV_PERIODIC_ENABLE
-        case EV_PERIODIC:
-            PYEV_WATCHER_START(ev_periodic, self);
-            break;
-#endif
-#if EV_SIGNAL_ENABLE
-        case EV_SIGNAL:
-            PYEV_WATCHER_START(ev_signal, self);
-            break;
-#endif
-#if EV_CHILD_ENABLE
-        case EV_CHILD:
-            PYEV_WATCHER_START(ev_child, self);
-            break;
-#endif
-#if EV_IDLE_ENABLE
-        case EV_IDLE:
-            PYEV_WATCHER_START(ev_idle, self);
-            break;
-#endif
-#if EV_PREPARE_ENABLE
-        case EV_PREPARE:
-            PYEV_WATCHER_START(ev_prepare, self);
-            break;
-#endif
-#if EV_CHECK_ENABLE
-        case EV_CHECK:
-            PYEV_WATCHER_START(ev_check, self);
-            break;
-#endif
-#if EV_EMBED_ENABLE
-        case EV_EMBED:
-            PYEV_WATCHER_START(ev_embed, self);
-            break;
-#endif
-#if EV_FORK_ENABLE
-        case EV_FORK:
-            PYEV_WATCHER_START(ev_fork, self);
-            break;
-#endif
-#if EV_ASYNC_ENABLE
-        case EV_ASYNC:
-            PYEV_WATCHER_START(ev_async, self);
-            break;
-#endif
-        default:
-            Py_FatalError("unknown watcher type");
-            break;
-    }
+    PYEV_BEGIN_LOCK(self->loop);
+    self->ops->start(self->loop->loop, self->watcher);
+    PYEV_END_LOCK();
 }
 
+
 void
 Watcher_Stop(Watcher *self)
 {
-    switch (self->type) {
-        case EV_IO:
-            PYEV_WATCHER_STOP(ev_io, self);
-            break;
-        case EV_TIMER:
-            PYEV_WATCHER_STOP(ev_timer, self);
-            break;
-#if EV_PERIODIC_ENABLE
-        case EV_PERIODIC:
-            PYEV_WATCHER_STOP(ev_periodic, self);
-            break;
-#endif
-#if EV_SIGNAL_ENABLE
-        case EV_SIGNAL:
-            PYEV_WATCHER_STOP(ev_signal, self);
-            break;
-#endif
-#if EV_CHILD_ENABLE
-        case EV_CHILD:
-            PYEV_WATCHER_STOP(ev_child, self);
-            break;
-#endif
-#if EV_IDLE_ENABLE
-        case EV_IDLE:
-            PYEV_WATCHER_STOP(ev_idle, self);
-            break;
-#endif
-#if EV_PREPARE_ENABLE
-        case EV_PREPARE:
-            PYEV_WATCHER_STOP(ev_prepare, self);
-            break;
-#endif
-#if EV_CHECK_ENABLE
-        case EV_CHECK:
-            PYEV_WATCHER_STOP(ev_check, self);
-            break;
-#endif
-#if EV_EMBED_ENABLE
-        case EV_EMBED:
-            PYEV_WATCHER_STOP(ev_embed, self);
-            break;
-#endif
-#if EV_FORK_ENABLE
-        case EV_FORK:
-            PYEV_WATCHER_STOP(ev_fork, self);
-            break;
-#endif
-#if EV_ASYNC_ENABLE
-        case EV_ASYNC:
-            PYEV_WATCHER_STOP(ev_async, self);
-            break;
-#endif
-        default:
-            Py_FatalError("unknown watcher type");
-            break;
+    PYEV_BEGIN_LOCK(self->loop);
+    self->ops->stop(self->loop->loop, self->watcher);
+    PYEV_END_LOCK();
+}
+
+
+int
+Watcher_IsActive(Watcher *self)
+{
+    if (self->ops->is_active) {
+        return self->ops->is_active(self->watcher);
     }
+    return ev_is_active(self->watcher);
 }
 
 
@@ -145,23 +50,43 @@ Watcher_Callback(struct ev_loop *loop, ev_watcher *watcher, int revents)
                              Py_TYPE(self)->tp_name, self);
             }
         }
-        PYEV_LOOP_EXIT(loop);
+        /* a Task waiting for us gets the error thrown into its coroutine */
+        if (Py_TYPE(self->callback) != &TaskType ||
+            Task_Resume((Task *)self->callback, self, revents)) {
+            PYEV_LOOP_EXIT(loop);
+        }
+    }
+    else if (Py_TYPE(self->callback) == &TaskType) {
+        /* a Task waiting for us, resumed without calling into Python. One
+           that isn't (any more) would leave us firing for nothing */
+        if (Task_Resume((Task *)self->callback, self, revents)) {
+            Watcher_Stop(self);
+        }
+    }
+    else if (self->callback != Py_None && self->loop->batching) {
+        if (EventBatch_Append(self->loop->events, (PyObject *)self, revents)) {
+            PYEV_LOOP_EXIT(loop);
+        }
     }
     else if (self->callback != Py_None) {
-        PyObject *pyrevents = PyInt_FromLong(revents);
+        /* the callback could be replaced (and released) while it runs */
+        PyObject *callback = self->callback;
+        PyObject *pyrevents = Revents_FromInt(revents);
         if (!pyrevents) {
             PYEV_LOOP_EXIT(loop);
         }
         else {
+            Py_INCREF(callback);
             PyObject *pyresult =
-                PyObject_CallFunctionObjArgs(self->callback, self, pyrevents, NULL);
+                Callback_Invoke(callback, (PyObject *)self, pyrevents);
             if (!pyresult) {
-                Loop_WarnOrStop(ev_userdata(loop), self->callback);
+                Loop_WarnOrStop(ev_userdata(loop), callback);
             }
             else {
                 Py_DECREF(pyresult);
             }
             Py_DECREF(pyrevents);
+            Py_DECREF(callback);
         }
     }
 #if EV_EMBED_ENABLE
@@ -172,22 +97,116 @@ Watcher_Callback(struct ev_loop *loop, ev_watcher *watcher, int revents)
 }
 
 
+/* bounded freelists, one per (static) watcher type */
+#define PYEV_FREELIST_TYPES 32
+#define PYEV_FREELIST_SIZE 128
+
+typedef struct {
+    PyTypeObject *type;
+    Watcher *head;
+    int count;
+} WatcherFreelist;
+
+static WatcherFreelist Watcher_Freelists[PYEV_FREELIST_TYPES];
+
+#ifdef Py_GIL_DISABLED
+/* the freelists are shared by all threads */
+static PyMutex Watcher_FreelistsMutex;
+#define PYEV_FREELIST_LOCK() PyMutex_Lock(&Watcher_FreelistsMutex)
+#define PYEV_FREELIST_UNLOCK() PyMutex_Unlock(&Watcher_FreelistsMutex)
+#else
+#define PYEV_FREELIST_LOCK()
+#define PYEV_FREELIST_UNLOCK()
+#endif
+
+
+/* must be called with PYEV_FREELIST_LOCK() held */
+WatcherFreelist *
+Watcher_Freelist(PyTypeObject *type)
+{
+    int i;
+
+    if (PyType_HasFeature(type, Py_TPFLAGS_HEAPTYPE) ||
+        type->tp_alloc != PyType_GenericAlloc) {
+        return NULL;
+    }
+    for (i = 0; i < PYEV_FREELIST_TYPES; i++) {
+        if (!Watcher_Freelists[i].type) {
+            Watcher_Freelists[i].type = type;
+        }
+        if (Watcher_Freelists[i].type == type) {
+            return &Watcher_Freelists[i];
+        }
+    }
+    return NULL;
+}
+
+
 Watcher *
-Watcher_New(PyTypeObject *type, int ev_type, size_t size)
+Watcher_Alloc(PyTypeObject *type)
 {
-    Watcher *self = (Watcher *)type->tp_alloc(type, 0);
+    WatcherFreelist *freelist;
+    Watcher *self = NULL;
+
+    PYEV_FREELIST_LOCK();
+    freelist = Watcher_Freelist(type);
+    if (freelist && freelist->head) {
+        self = freelist->head;
+        freelist->head = (Watcher *)self->data;
+        freelist->count--;
+    }
+    PYEV_FREELIST_UNLOCK();
     if (!self) {
-        return NULL;
+        return (Watcher *)type->tp_alloc(type, 0);
     }
-    self->watcher = PyMem_Malloc(size);
-    if (!self->watcher) {
-        PyErr_NoMemory();
-        Py_DECREF(self);
+    memset((char *)self + sizeof(PyObject), 0,
+           type->tp_basicsize - sizeof(PyObject));
+    PyObject_Init((PyObject *)self, type);
+    PyObject_GC_Track(self);
+    return self;
+}
+
+
+void
+Watcher_Free(Watcher *self)
+{
+    WatcherFreelist *freelist;
+    int cached = 0;
+
+    PYEV_FREELIST_LOCK();
+    freelist = Watcher_Freelist(Py_TYPE(self));
+    if (freelist && freelist->count < PYEV_FREELIST_SIZE) {
+        /* self->data is free to chain the list */
+        self->data = (PyObject *)freelist->head;
+        freelist->head = self;
+        freelist->count++;
+        cached = 1;
+    }
+    PYEV_FREELIST_UNLOCK();
+    if (!cached) {
+        Py_TYPE(self)->tp_free((PyObject *)self);
+    }
+}
+
+
+Watcher *
+Watcher_New(PyTypeObject *type, const WatcherOps *ops)
+{
+    PyTypeObject *base = type;
+    Watcher *self = Watcher_Alloc(type);
+    if (!self) {
         return NULL;
     }
+    /* the libev watcher sits at the end of the first static type (see
+       PYEV_WATCHER_SIZE), Python subclasses add their slots after it */
+    while (PyType_HasFeature(base, Py_TPFLAGS_HEAPTYPE)) {
+        base = base->tp_base;
+    }
+    self->watcher =
+        (ev_watcher *)((char *)self + base->tp_basicsize - ops->size);
     ev_init(self->watcher, Watcher_Callback);
     self->watcher->data = self;
-    self->type = ev_type;
+    self->ops = ops;
     return self;
 }
 
@@ -196,15 +215,7 @@ Watcher_New(PyTypeObject *type, int ev_type, size_t size)
 int
 Watcher_SetCallback(Watcher *self, PyObject *callback)
 {
-    /*switch (self->type) {
-        case EV_EMBED:
-            PYEV_CHECK_CALLABLE_OR_NONE(callback);
-            break;
-        default:
-            PYEV_CHECK_CALLABLE(callback);
-            break;
-    }*/
-    if (self->type == EV_EMBED) {
+    if (self->ops->callback_or_none) {
         PYEV_CHECK_CALLABLE_OR_NONE(callback);
     }
     else {
@@ -212,7 +223,9 @@ Watcher_SetCallback(Watcher *self, PyObject *callback)
     }
     PyObject *tmp = self->callback;
     Py_INCREF(callback);
+    PYEV_BEGIN_LOCK(self->loop);
     self->callback = callback;
+    PYEV_END_LOCK();
     Py_XDECREF(tmp);
     return 0;
 }
@@ -270,6 +283,10 @@ Watcher_tp_traverse(Watcher *self, visitproc visit, void *arg)
 static int
 Watcher_tp_clear(Watcher *self)
 {
+    /* stop it while we still have a loop */
+    if (self->watcher && self->loop) {
+        Watcher_Stop(self);
+    }
     Py_CLEAR(self->data);
     Py_CLEAR(self->callback);
     Py_CLEAR(self->loop);
@@ -282,15 +299,10 @@ static void
 Watcher_tp_dealloc(Watcher *self)
 {
     printf("Watcher_tp_dealloc\n");
+    PyObject_GC_UnTrack(self);
     Watcher_tp_clear(self);
-    if (self->watcher) {
-        if (self->loop) {
-            Watcher_Stop(self);
-        }
-        PyMem_Free(self->watcher);
-        self->watcher = NULL;
-    }
-    Py_TYPE(self)->tp_free((PyObject *)self);
+    self->watcher = NULL;
+    Watcher_Free(self);
     printf("Watcher_tp_dealloc done\n");
 }
 
@@ -326,7 +338,12 @@ PyDoc_STRVAR(Watcher_clear_doc,
 static PyObject *
 Watcher_clear(Watcher *self)
 {
-    return PyInt_FromLong(ev_clear_pending(self->loop->loop, self->watcher));
+    int revents;
+
+    PYEV_BEGIN_LOCK(self->loop);
+    revents = ev_clear_pending(self->loop->loop, self->watcher);
+    PYEV_END_LOCK();
+    return PyInt_FromLong(revents);
 }
 
 
@@ -342,7 +359,9 @@ Watcher_invoke(Watcher *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "i:invoke", &revents)) {
         return NULL;
     }
+    PYEV_BEGIN_LOCK(self->loop);
     ev_invoke(self->loop->loop, self->watcher, revents);
+    PYEV_END_LOCK();
     Py_RETURN_NONE;
 }
 
@@ -359,7 +378,9 @@ Watcher_feed(Watcher *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "i:feed", &revents)) {
         return NULL;
     }
+    PYEV_BEGIN_LOCK(self->loop);
     ev_feed_event(self->loop->loop, self->watcher, revents);
+    PYEV_END_LOCK();
     Py_RETURN_NONE;
 }
 
@@ -392,7 +413,7 @@ static PyMemberDef Watcher_tp_members[] = {
 static PyObject *
 Watcher_active_get(Watcher *self, void *closure)
 {
-    return PyBool_FromLong(ev_is_active(self->watcher));
+    return PyBool_FromLong(Watcher_IsActive(self));
 }
 
 
@@ -21,9 +21,22 @@
 #define PY_SSIZE_T_CLEAN
 #include "Python.h"
 #include "structmember.h"
+#include "pythread.h"
 
 #include <ev.h>
 
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
 
 /*******************************************************************************
 * helpers
@@ -33,7 +46,10 @@
 #define PyInt_FromLong PyLong_FromLong
 #define PyInt_AsLong PyLong_AsLong
 #define PyInt_FromUnsignedLong PyLong_FromUnsignedLong
+#define PyInt_FromSsize_t PyLong_FromSsize_t
 #define PyString_FromFormat PyUnicode_FromFormat
+#define PyString_FromString PyUnicode_FromString
+#define PyString_FromPath PyUnicode_DecodeFSDefaultAndSize
 #else
 PyObject *
 PyInt_FromUnsignedLong(unsigned long value)
@@ -43,6 +59,14 @@ PyInt_FromUnsignedLong(unsigned long value)
     }
     return PyInt_FromLong((long)value);
 }
+#define PyString_FromPath PyString_FromStringAndSize
+#endif
+
+
+#if PY_MAJOR_VERSION >= 3
+#define PYEV_BUFFER_FORMAT "y*"
+#else
+#define PYEV_BUFFER_FORMAT "s*"
 #endif
 
 
@@ -110,8 +134,76 @@ PyInt_FromUnsignedLong(unsigned long value)
 #define PYEV_WATCHER_SET(W) PYEV_WATCHER_CHECK_ACTIVE(W, "set", NULL)
 
 
-#define PYEV_WATCHER_START(t, w) t##_start((w)->loop->loop, (t *)(w)->watcher)
-#define PYEV_WATCHER_STOP(t, w) t##_stop((w)->loop->loop, (t *)(w)->watcher)
+/* true if libev's headers are at least version major.minor */
+#define PYEV_LIBEV_VERSION(major, minor) \
+    (EV_VERSION_MAJOR > (major) || \
+     (EV_VERSION_MAJOR == (major) && EV_VERSION_MINOR >= (minor)))
+
+
+/* same as ev_io_modify (libev >= 4.25) */
+#define PYEV_IO_MODIFY(io, e) \
+    do { \
+        (io)->events = ((io)->events & EV__IOFDSET) | (e); \
+    } while (0)
+
+
+/* without the GIL, a loop (and its watchers) is protected by a critical
+   section on the Loop object. It is held while the loop runs, and released
+   while it polls, with the GIL (see Loop_Release) */
+#if PY_VERSION_HEX >= 0x030D0000
+#define PYEV_BEGIN_LOCK(o) Py_BEGIN_CRITICAL_SECTION((o))
+#define PYEV_END_LOCK() Py_END_CRITICAL_SECTION()
+#else
+#define PYEV_BEGIN_LOCK(o) {
+#define PYEV_END_LOCK() }
+#endif
+
+
+/* the current interpreter */
+#if PY_VERSION_HEX >= 0x03090000
+#define PYEV_INTERPRETER() PyInterpreterState_Get()
+#else
+#define PYEV_INTERPRETER() (PyThreadState_GET()->interp)
+#endif
+
+
+/* PEP 489 multi-phase initialization */
+#if PY_VERSION_HEX >= 0x03050000
+#define PYEV_MULTI_PHASE_INIT 1
+#endif
+
+
+/* pyev.asyncio (needs contextvars) */
+#if PY_VERSION_HEX >= 0x03070000
+#define PYEV_ASYNCIO_ENABLE 1
+#endif
+
+
+/* the ready queue of a Loop (see Loop_Schedule) */
+#if EV_CHECK_ENABLE && EV_IDLE_ENABLE
+#define PYEV_READY_ENABLE 1
+#endif
+
+
+/* watchers keep their libev struct right after their own (see Watcher_New) */
+#define PYEV_WATCHER_SIZE(T, t) (sizeof(T) + sizeof(t))
+
+
+/* defines t##_ops, the WatcherOps of libev watchers of type t */
+#define PYEV_WATCHER_OPS(t, T, none) \
+    static void \
+    t##_ops_start(struct ev_loop *loop, ev_watcher *watcher) \
+    { \
+        t##_start(loop, (t *)watcher); \
+    } \
+    static void \
+    t##_ops_stop(struct ev_loop *loop, ev_watcher *watcher) \
+    { \
+        t##_stop(loop, (t *)watcher); \
+    } \
+    static const WatcherOps t##_ops = { \
+        (T), sizeof(t), t##_ops_start, t##_ops_stop, NULL, (none) \
+    }
 
 
 #define PYEV_LOOP_EXIT(l) ev_break((l), EVBREAK_ALL)
@@ -147,6 +239,127 @@ Boolean_Predicate(PyObject *arg, void *addr)
 }
 
 
+/* convert a socket address to the same Python object the socket module uses */
+PyObject *
+Sockaddr_AsPyObject(struct sockaddr *addr, socklen_t addrlen)
+{
+    char host[INET6_ADDRSTRLEN];
+
+    if (!addrlen) {
+        Py_RETURN_NONE;
+    }
+    switch (addr->sa_family) {
+        case AF_INET: {
+            struct sockaddr_in *in = (struct sockaddr_in *)addr;
+            if (!inet_ntop(AF_INET, &in->sin_addr, host, sizeof(host))) {
+                return PyErr_SetFromErrno(PyExc_OSError);
+            }
+            return Py_BuildValue("(Ni)", PyString_FromString(host),
+                                 ntohs(in->sin_port));
+        }
+        case AF_INET6: {
+            struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)addr;
+            if (!inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host))) {
+                return PyErr_SetFromErrno(PyExc_OSError);
+            }
+            return Py_BuildValue("(NiII)", PyString_FromString(host),
+                                 ntohs(in6->sin6_port),
+                                 ntohl(in6->sin6_flowinfo),
+                                 in6->sin6_scope_id);
+        }
+        case AF_UNIX: {
+            struct sockaddr_un *un = (struct sockaddr_un *)addr;
+            Py_ssize_t length = addrlen - offsetof(struct sockaddr_un, sun_path);
+            if (length <= 0) {
+                return PyString_FromPath("", 0);
+            }
+            if (un->sun_path[0] == 0) {
+                /* linux abstract namespace */
+                return PyBytes_FromStringAndSize(un->sun_path, length);
+            }
+            return PyString_FromPath(un->sun_path, strnlen(un->sun_path, length));
+        }
+        default:
+            Py_RETURN_NONE;
+    }
+}
+
+
+/* revents with a single bit set, created once and never released */
+#define PYEV_REVENTS_BITS 31
+static PyObject *Revents_Cache[PYEV_REVENTS_BITS];
+
+
+int
+Revents_InitCache(void)
+{
+    int bit;
+
+    for (bit = 0; bit < PYEV_REVENTS_BITS; bit++) {
+        if (!Revents_Cache[bit]) {
+            Revents_Cache[bit] = PyInt_FromLong(1L << bit);
+            if (!Revents_Cache[bit]) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+/* revents as a Python int, only combined events need an allocation */
+PyObject *
+Revents_FromInt(int revents)
+{
+    int bit = 0;
+
+    if (revents > 0 && !(revents & (revents - 1))) {
+        while (!(revents & (1 << bit))) {
+            bit++;
+        }
+        Py_INCREF(Revents_Cache[bit]);
+        return Revents_Cache[bit];
+    }
+    return PyInt_FromLong(revents);
+}
+
+
+/* callback(watcher, arg), without building an argument tuple when the
+   interpreter lets us */
+PyObject *
+Callback_Invoke(PyObject *callback, PyObject *watcher, PyObject *arg)
+{
+    /* args[0] is scratch space for the bound method's self */
+    PyObject *args[3] = {NULL, watcher, arg};
+
+    if (PyMethod_Check(callback) && PyMethod_GET_SELF(callback)) {
+        args[0] = PyMethod_GET_SELF(callback);
+        callback = PyMethod_GET_FUNCTION(callback);
+#if PY_VERSION_HEX >= 0x03090000
+        return PyObject_Vectorcall(callback, args, 3, NULL);
+#elif PY_VERSION_HEX >= 0x03080000
+        return _PyObject_Vectorcall(callback, args, 3, NULL);
+#elif PY_VERSION_HEX >= 0x03060000
+        return _PyObject_FastCall(callback, args, 3);
+#else
+        return PyObject_CallFunctionObjArgs(callback, args[0], watcher, arg,
+                                            NULL);
+#endif
+    }
+#if PY_VERSION_HEX >= 0x03090000
+    return PyObject_Vectorcall(callback, args + 1,
+                               2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+#elif PY_VERSION_HEX >= 0x03080000
+    return _PyObject_Vectorcall(callback, args + 1,
+                                2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+#elif PY_VERSION_HEX >= 0x03060000
+    return _PyObject_FastCall(callback, args + 1, 2);
+#else
+    return PyObject_CallFunctionObjArgs(callback, watcher, arg, NULL);
+#endif
+}
+
+
 /*******************************************************************************
 * objects
 *******************************************************************************/
@@ -155,21 +368,145 @@ Boolean_Predicate(PyObject *arg, void *addr)
 static PyObject *Error = NULL;
 
 
+/* EventBatch - (watcher, revents) pairs collected in one loop iteration */
+typedef struct {
+    PyObject_HEAD
+    PyObject **watchers;
+    int *revents;
+    Py_ssize_t len;
+    Py_ssize_t size;
+} EventBatch;
+static PyTypeObject EventBatchType;
+
+
+/* Pool - worker threads running blocking calls on behalf of a Loop */
+typedef struct _PoolTask {
+    struct _PoolTask *next;
+    PyObject *callable;
+    PyObject *args;
+    PyObject *callback;
+    PyObject *result;
+    PyObject *error;
+} PoolTask;
+
+typedef struct {
+    ev_async async;
+    struct ev_loop *loop;
+    pthread_mutex_t mutex;
+    pthread_cond_t ready;
+    pthread_cond_t room;
+    pthread_cond_t done;
+    PoolTask *first;
+    PoolTask *last;
+    PoolTask *completed;
+    Py_ssize_t queued;
+    Py_ssize_t maxsize;
+    Py_ssize_t outstanding;
+    int workers;
+    int shutdown;
+} Pool;
+
+
 /* Loop */
+typedef struct _Task Task;
+typedef struct _Handle Handle;
+
 typedef struct {
     PyObject_HEAD
     struct ev_loop *loop;
     PyObject *callback;
     PyObject *data;
+    PyObject *batch;
+    EventBatch *events;
+    int batching;
+    Pool *pool;
+    int pool_size;
+    Py_ssize_t pool_maxsize;
     PyThreadState *tstate;
     double io_interval;
     double timeout_interval;
+#if EV_IDLE_ENABLE
+    ev_idle busy;
+#endif
+    double busy_poll;
+    ev_tstamp busy_until;
+    unsigned long spins;
+    unsigned long sleeps;
+    int spinning;
     int debug;
+#ifdef PYEV_READY_ENABLE
+    ev_check ready_check;
+    ev_idle ready_idle;
+#endif
+    Task *ready_first;
+    Task *ready_last;
+    Handle **soon;
+    Py_ssize_t soon_size;
+    Py_ssize_t soon_head;
+    Py_ssize_t soon_len;
+    Handle **later;
+    Py_ssize_t later_size;
+    Py_ssize_t later_len;
+    unsigned long later_seq;
+    ev_timer later_timer;
 } Loop;
 static PyTypeObject LoopType;
+void Loop_WarnOrStop(Loop *self, PyObject *context);
+int Loop_Schedule(Loop *self, Task *task);
+void Loop_CancelLater(Loop *self, Handle *handle);
+
+/* Handle - a callback queued by Loop.call_soon() or Loop.call_later() */
+struct _Handle {
+    PyObject_HEAD
+    Loop *loop;
+    PyObject *callback;
+    PyObject *args;
+    double when;
+    unsigned long seq;
+    Py_ssize_t index;
+    int cancelled;
+};
+static PyTypeObject HandleType;
 
-/* the 'default loop' */
+/* the 'default loop', and the interpreter it belongs to */
 static Loop *DefaultLoop = NULL;
+static PyInterpreterState *DefaultLoopInterpreter = NULL;
+
+
+/* LoopGroup - loops running in their own threads */
+typedef struct _LoopGroup LoopGroup;
+
+typedef struct {
+    ev_async async;
+    Loop *loop;
+    PyObject *queue;
+    LoopGroup *group;
+    PyThread_type_lock done;
+    long ident;
+    int running;
+    int stopping;
+} LoopGroupMember;
+
+struct _LoopGroup {
+    PyObject_HEAD
+    PyObject *loops;
+    LoopGroupMember *members;
+    Py_ssize_t count;
+    Py_ssize_t next;
+};
+static PyTypeObject LoopGroupType;
+
+
+/* what a watcher type needs from libev, shared by all the types built on the
+   same libev watcher (see PYEV_WATCHER_OPS) */
+typedef struct {
+    int type;
+    size_t size;
+    void (*start)(struct ev_loop *, ev_watcher *);
+    void (*stop)(struct ev_loop *, ev_watcher *);
+    int (*is_active)(ev_watcher *);           /* NULL: ev_is_active() */
+    int callback_or_none;                     /* callback can be None */
+} WatcherOps;
 
 
 /* Watcher base - not exposed */
@@ -179,7 +516,7 @@ typedef struct {
     Loop *loop;
     PyObject *callback;
     PyObject *data;
-    int type;
+    const WatcherOps *ops;
 } Watcher;
 static PyTypeObject WatcherType;
 
@@ -187,9 +524,108 @@ static PyTypeObject WatcherType;
 /* Watchers */
 
 static PyTypeObject IoType;
+int Io_CheckEvents(int events);
+int Io_CheckModify(Watcher *self);
+void Io_Modify(Watcher *self, int events);
+
+typedef struct {
+    Watcher watcher;
+    PyObject *buffer;
+    Py_ssize_t size;
+    Py_ssize_t start;
+    Py_ssize_t end;
+    Py_ssize_t bufsize;
+    PyObject *delimiter;
+    Py_ssize_t scanned;
+    int prefix;
+    int little_endian;
+    Py_ssize_t max_frame;
+    Py_buffer *queue;
+    Py_ssize_t queue_size;
+    Py_ssize_t queue_head;
+    Py_ssize_t queue_tail;
+    Py_ssize_t offset;
+    Py_ssize_t queued;
+    unsigned long generation;
+    int error;
+    int eof;
+} Stream;
+static PyTypeObject StreamType;
+
+typedef struct {
+    Watcher watcher;
+    PyObject *stream_callback;
+    int batch;
+    int error;
+} Acceptor;
+static PyTypeObject AcceptorType;
+
+typedef struct {
+    Watcher watcher;
+    PyObject *pool;
+    struct mmsghdr *msgs;
+    struct iovec *iov;
+    struct sockaddr_storage *addrs;
+    Py_ssize_t count;
+    Py_ssize_t size;
+    int family;
+    int error;
+} Datagram;
+static PyTypeObject DatagramType;
+
+typedef struct {
+    Watcher watcher;
+    ev_io *output;
+    int pipe[2];
+    char *buffer;
+    Py_ssize_t start;
+    Py_ssize_t pending;
+    Py_ssize_t threshold;
+    Py_ssize_t unreported;
+    unsigned PY_LONG_LONG transferred;
+    int eof;
+    int error;
+} Relay;
+static PyTypeObject RelayType;
+
+typedef struct {
+    Watcher watcher;
+    int file;
+    off_t offset;
+    PY_LONG_LONG remaining;
+    unsigned PY_LONG_LONG sent;
+    char *buffer;
+    int copy;
+    int error;
+} FileSender;
+static PyTypeObject FileSenderType;
 
 static PyTypeObject TimerType;
 
+typedef struct {
+    PyObject *key;
+    unsigned PY_LONG_LONG expires;
+    unsigned PY_LONG_LONG timeout;
+    unsigned int next;
+    unsigned int prev;
+    unsigned int slot;
+    unsigned int generation;
+} TimerWheelEntry;
+
+typedef struct {
+    Watcher watcher;
+    TimerWheelEntry *entries;
+    unsigned int size;
+    unsigned int count;
+    unsigned int free;
+    unsigned int slots[4 << 8];
+    unsigned PY_LONG_LONG ticks;
+    double origin;
+    double resolution;
+    int started;
+} TimerWheel;
+static PyTypeObject TimerWheelType;
+
 #if EV_PERIODIC_ENABLE
 static PyTypeObject PeriodicBaseType;
 static PyTypeObject PeriodicType;
@@ -240,18 +676,155 @@ static PyTypeObject ForkType;
 #endif
 
 #if EV_ASYNC_ENABLE
+/* objects sent to an Async, in a lock-free (multi-producer, single-consumer)
+   stack */
+typedef struct _AsyncNode {
+    struct _AsyncNode *next;
+    PyObject *obj;
+} AsyncNode;
+
+typedef struct {
+    Watcher watcher;
+    AsyncNode *head;
+} Async;
 static PyTypeObject AsyncType;
 #endif
 
+/* Task - a coroutine driven by a Loop */
+struct _Task {
+    PyObject_HEAD
+    Task *next;
+    Loop *loop;
+    PyObject *coro;
+    PyObject *waiting;
+    PyObject *previous;
+    PyObject *result;
+    PyObject *error;
+    int running;
+    int done;
+    int cancelled;
+};
+static PyTypeObject TaskType;
+PyObject *Task_New(Loop *loop, PyObject *coro);
+void Task_Run(Task *self);
+int Task_Resume(Task *self, Watcher *watcher, int revents);
+
+/* Wait - an fd readiness or a delay a Task can wait for */
+typedef struct {
+    PyObject_HEAD
+    Watcher *watcher;
+    double after;
+    int fired;
+} Wait;
+static PyTypeObject WaitType;
+PyObject *Wait_NewIo(Loop *loop, PyObject *fd, int events);
+PyObject *Wait_NewTimer(Loop *loop, double after);
+
+#ifdef PYEV_ASYNCIO_ENABLE
+/* pyev.asyncio, an asyncio event loop running on a Loop */
+typedef struct _AsyncioCore AsyncioCore;
+
+typedef struct _AsyncioHandle {
+    PyObject_HEAD
+    struct _AsyncioHandle *next;
+    AsyncioCore *core;
+    PyObject *callback;
+    PyObject *args;
+    PyObject *context;
+    int cancelled;
+    int queued;
+} AsyncioHandle;
+static PyTypeObject AsyncioHandleType;
+
+typedef struct _AsyncioTimerHandle {
+    AsyncioHandle handle;
+    struct _AsyncioTimerHandle *prev;
+    struct _AsyncioTimerHandle *next;
+    ev_timer timer;
+    double when;
+} AsyncioTimerHandle;
+static PyTypeObject AsyncioTimerHandleType;
+
+/* the reader and writer of a fd */
+typedef struct {
+    ev_io io;
+    AsyncioHandle *reader;
+    AsyncioHandle *writer;
+} AsyncioIo;
+
+struct _AsyncioCore {
+    PyObject_HEAD
+    Loop *loop;
+    PyObject *owner;
+    AsyncioHandle *first;
+    AsyncioHandle *last;
+    Py_ssize_t ready;
+    AsyncioTimerHandle *timers;
+    AsyncioIo **fds;
+    int nfds;
+    int closed;
+};
+static PyTypeObject AsyncioCoreType;
+double Asyncio_Time(void);
+void AsyncioCore_Push(AsyncioCore *self, AsyncioHandle *handle);
+
+typedef struct {
+    PyObject_HEAD
+    AsyncioCore *core;
+    PyObject *loop;
+    PyObject *sock;
+    PyObject *protocol;
+    PyObject *server;
+    PyObject *waiter;
+    PyObject *extra;
+    PyObject *weakreflist;
+    ev_io reader;
+    ev_io writer;
+    Py_buffer *queue;
+    Py_ssize_t queue_size;
+    Py_ssize_t queue_head;
+    Py_ssize_t queue_tail;
+    Py_ssize_t offset;
+    Py_ssize_t queued;
+    Py_ssize_t high;
+    Py_ssize_t low;
+    int fd;
+    int buffered;
+    int paused;
+    int protocol_paused;
+    int closing;
+    int eof;
+    int conn_lost;
+} AsyncioTransport;
+static PyTypeObject AsyncioTransportType;
+PyObject *AsyncioTransport_Class(PyObject **cache, const char *module,
+                                 const char *name);
+int AsyncioTransport_Init(void);
+PyObject *AsyncioTransport_New(PyObject *loop, PyObject *sock,
+                               PyObject *protocol, PyObject *waiter,
+                               PyObject *extra, PyObject *server);
+int _PyModule_AddType(PyObject *module, const char *name, PyTypeObject *type);
+#endif
+
 
 /*******************************************************************************
 * types
 *******************************************************************************/
 
+#include "EventBatch.c"
+#include "Pool.c"
+#include "Handle.c"
 #include "Loop.c"
+#include "LoopGroup.c"
 #include "Watcher.c"
 #include "Io.c"
+#include "Stream.c"
+#include "Acceptor.c"
+#include "Datagram.c"
+#include "Relay.c"
+#include "FileSender.c"
 #include "Timer.c"
+#include "TimerWheel.c"
 
 #if EV_PERIODIC_ENABLE
 #include "PeriodicBase.c"
@@ -293,6 +866,15 @@ static PyTypeObject AsyncType;
 #include "Async.c"
 #endif
 
+#include "Wait.c"
+#include "Task.c"
+
+#ifdef PYEV_ASYNCIO_ENABLE
+#include "AsyncioHandle.c"
+#include "AsyncioLoop.c"
+#include "AsyncioTransport.c"
+#endif
+
 
 /*******************************************************************************
  utils
@@ -304,14 +886,22 @@ static PyTypeObject AsyncType;
     PyModule_AddIntConstant((m), #c, (unsigned int)(c))
 
 
-/* allocate memory from the Python heap */
+/* allocate memory from the Python heap, the raw domain (3.4+) doesn't need
+   the GIL and isn't tied to an interpreter */
 static void *
 pyev_allocator(void *ptr, long size)
 {
+#if PY_VERSION_HEX >= 0x03040000
+    if (size) {
+        return PyMem_RawRealloc(ptr, size);
+    }
+    PyMem_RawFree(ptr);
+#else
     if (size) {
         return PyMem_Realloc(ptr, size);
     }
     PyMem_Free(ptr);
+#endif
     return NULL;
 }
 
@@ -338,7 +928,7 @@ PyType_ReadyWatcher(PyTypeObject *type, PyTypeObject *base)
 
 
 int
-PyModule_AddType(PyObject *module, const char *name, PyTypeObject *type)
+PyModule_AddReadyType(PyObject *module, const char *name, PyTypeObject *type)
 {
     if (PyType_Ready(type)) {
         return -1;
@@ -371,23 +961,44 @@ PyDoc_STRVAR(pyev_m_doc,
                       io_interval=0.0, timeout_interval=0.0, debug=False]) -> 'the default loop' */
 PyDoc_STRVAR(pyev_default_loop_doc,
 "default_loop([flags=EVFLAG_AUTO, callback=None, data=None,\n\
-               io_interval=0.0, timeout_interval=0.0, debug=False]) -> 'the default loop'");
+               io_interval=0.0, timeout_interval=0.0, debug=False,\n\
+               busy_poll=0.0]) -> 'the default loop'");
 
 static PyObject *
 pyev_default_loop(PyObject *module, PyObject *args, PyObject *kwargs)
 {
+    Loop *result = NULL;
+    int created = 0;
+
+    PYEV_BEGIN_LOCK(module);
     if (!DefaultLoop) {
         DefaultLoop = Loop_New(&LoopType, args, kwargs, 1);
+        DefaultLoopInterpreter = PYEV_INTERPRETER();
+        result = DefaultLoop;
+        created = 1;
     }
-    else {
-        if (PyErr_WarnEx(PyExc_RuntimeWarning,
-                         "returning the 'default loop' created earlier, "
-                         "arguments ignored (if provided).", 1)) {
-            return NULL;
-        }
+    else if (DefaultLoopInterpreter == PYEV_INTERPRETER()) {
         Py_INCREF(DefaultLoop);
+        result = DefaultLoop;
+    }
+    PYEV_END_LOCK();
+    if (!result) {
+        if (!created) {
+            /* libev has only one default loop per process */
+            PyErr_SetString(Error,
+                            "the 'default loop' belongs to another "
+                            "interpreter");
+        }
+        return NULL;
+    }
+    if (!created &&
+        PyErr_WarnEx(PyExc_RuntimeWarning,
+                     "returning the 'default loop' created earlier, "
+                     "arguments ignored (if provided).", 1)) {
+        Py_DECREF(result);
+        return NULL;
     }
-    return (PyObject *)DefaultLoop;
+    return (PyObject *)result;
 }
 
 
@@ -490,6 +1101,56 @@ pyev_abi_version(PyObject *module)
 }
 
 
+/* pyev.bench_dispatch(callback[, count=1000000]) -> float */
+PyDoc_STRVAR(pyev_bench_dispatch_doc,
+"bench_dispatch(callback[, count=1000000]) -> float");
+
+static PyObject *
+pyev_bench_dispatch(PyObject *module, PyObject *args)
+{
+    PyObject *callback, *pyloop = NULL, *pyargs = NULL, *kwargs = NULL;
+    Watcher *timer = NULL;
+    Py_ssize_t count = 1000000, i;
+    double start, elapsed;
+
+    if (!PyArg_ParseTuple(args, "O|n:bench_dispatch", &callback, &count)) {
+        return NULL;
+    }
+    if (count <= 0) {
+        PyErr_SetString(PyExc_ValueError, "'count' must be positive");
+        return NULL;
+    }
+    /* debug, so that an exception in callback stops the run */
+    pyargs = PyTuple_New(0);
+    kwargs = Py_BuildValue("{s:O}", "debug", Py_True);
+    if (pyargs && kwargs) {
+        pyloop = PyObject_Call((PyObject *)&LoopType, pyargs, kwargs);
+    }
+    Py_XDECREF(pyargs);
+    Py_XDECREF(kwargs);
+    if (!pyloop) {
+        return NULL;
+    }
+    timer = (Watcher *)PyObject_CallFunction((PyObject *)&TimerType, "ddOO",
+                                             0.0, 0.0, pyloop, callback);
+    if (!timer) {
+        Py_DECREF(pyloop);
+        return NULL;
+    }
+    start = ev_time();
+    for (i = 0; i < count && !PyErr_Occurred(); i++) {
+        ev_invoke(((Loop *)pyloop)->loop, timer->watcher, EV_TIMER);
+    }
+    elapsed = ev_time() - start;
+    Py_DECREF(timer);
+    Py_DECREF(pyloop);
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    return PyFloat_FromDouble(elapsed * 1e9 / count);
+}
+
+
 /* pyev_module.m_methods */
 static PyMethodDef pyev_m_methods[] = {
     {"default_loop", (PyCFunction)pyev_default_loop,
@@ -512,50 +1173,45 @@ static PyMethodDef pyev_m_methods[] = {
      METH_NOARGS, pyev_abi_version_doc},
     {"version", (PyCFunction)pyev_abi_version,
      METH_NOARGS, pyev_abi_version_doc},
+    {"bench_dispatch", (PyCFunction)pyev_bench_dispatch,
+     METH_VARARGS, pyev_bench_dispatch_doc},
     {NULL} /* Sentinel */
 };
 
 
-#if PY_MAJOR_VERSION >= 3
-/* pyev_module */
-static PyModuleDef pyev_module = {
-    PyModuleDef_HEAD_INIT,
-    "pyev",                                   /*m_name*/
-    pyev_m_doc,                               /*m_doc*/
-    -1,                                       /*m_size*/
-    pyev_m_methods,                           /*m_methods*/
-};
-#endif
-
-
-/* pyev_module initialization */
-PyObject *
-init_pyev(void)
+/* pyev_module execution, once per interpreter (and per import) on Python
+   3.5+. The types, pyev.Error and the cached revents are process wide, they
+   are only created the first time */
+static int
+pyev_exec(PyObject *pyev)
 {
-    /* pyev */
-    PyObject *pyev = NULL;
-#if PY_MAJOR_VERSION >= 3
-    pyev = PyModule_Create(&pyev_module);
-#else
-    pyev = Py_InitModule3("pyev", pyev_m_methods, pyev_m_doc);
+#ifdef PYEV_ASYNCIO_ENABLE
+    PyObject *asyncio;
 #endif
-    if (!pyev) {
-        return NULL;
-    }
+
     /* pyev.__version__ */
     if (PyModule_AddStringConstant(pyev, "__version__", PYEV_VERSION)) {
-        goto fail;
+        return -1;
     }
     /* pyev.Error */
-    Error = PyErr_NewException("pyev.Error", NULL, NULL);
-    if (!Error || PyModule_AddObject(pyev, "Error", Error)) {
-        Py_XDECREF(Error);
-        goto fail;
+    if (!Error && !(Error = PyErr_NewException("pyev.Error", NULL, NULL))) {
+        return -1;
+    }
+    Py_INCREF(Error);
+    if (PyModule_AddObject(pyev, "Error", Error)) {
+        Py_DECREF(Error);
+        return -1;
+    }
+    /* cached revents */
+    if (Revents_InitCache()) {
+        return -1;
     }
     /* types and constants */
     if (
         /* loop */
-        PyModule_AddType(pyev, "Loop", &LoopType) ||
+        PyType_Ready(&EventBatchType) ||
+        PyModule_AddReadyType(pyev, "Loop", &LoopType) ||
+        PyModule_AddReadyType(pyev, "LoopGroup", &LoopGroupType) ||
         PyModule_AddUnsignedIntMacro(pyev, EVFLAG_AUTO) ||
         PyModule_AddUnsignedIntMacro(pyev, EVFLAG_NOENV) ||
         PyModule_AddUnsignedIntMacro(pyev, EVFLAG_FORKCHECK) ||
@@ -567,6 +1223,12 @@ init_pyev(void)
         PyModule_AddUnsignedIntMacro(pyev, EVBACKEND_KQUEUE) ||
         PyModule_AddUnsignedIntMacro(pyev, EVBACKEND_DEVPOLL) ||
         PyModule_AddUnsignedIntMacro(pyev, EVBACKEND_PORT) ||
+#if PYEV_LIBEV_VERSION(4, 27)
+        PyModule_AddUnsignedIntMacro(pyev, EVBACKEND_LINUXAIO) ||
+#endif
+#if PYEV_LIBEV_VERSION(4, 31)
+        PyModule_AddUnsignedIntMacro(pyev, EVBACKEND_IOURING) ||
+#endif
         PyModule_AddUnsignedIntMacro(pyev, EVBACKEND_ALL) ||
         PyModule_AddUnsignedIntMacro(pyev, EVBACKEND_MASK) ||
         PyModule_AddIntMacro(pyev, EVRUN_NOWAIT) ||
@@ -579,7 +1241,13 @@ init_pyev(void)
         PyModule_AddIntMacro(pyev, EV_READ) ||
         PyModule_AddIntMacro(pyev, EV_WRITE) ||
         PyModule_AddIntMacro(pyev, EV_IO) ||
+        PyModule_AddWatcher(pyev, "Stream", &StreamType, &IoType) ||
+        PyModule_AddWatcher(pyev, "Acceptor", &AcceptorType, &IoType) ||
+        PyModule_AddWatcher(pyev, "Datagram", &DatagramType, &IoType) ||
+        PyModule_AddWatcher(pyev, "Relay", &RelayType, &IoType) ||
+        PyModule_AddWatcher(pyev, "FileSender", &FileSenderType, &IoType) ||
         PyModule_AddWatcher(pyev, "Timer", &TimerType, NULL) ||
+        PyModule_AddWatcher(pyev, "TimerWheel", &TimerWheelType, NULL) ||
         PyModule_AddIntMacro(pyev, EV_TIMER) ||
 #if EV_PERIODIC_ENABLE
         PyType_ReadyWatcher(&PeriodicBaseType, NULL) ||
@@ -621,6 +1289,11 @@ init_pyev(void)
         PyModule_AddWatcher(pyev, "Async", &AsyncType, NULL) ||
         PyModule_AddIntMacro(pyev, EV_ASYNC) ||
 #endif
+        /* callbacks */
+        PyModule_AddReadyType(pyev, "Handle", &HandleType) ||
+        /* coroutines */
+        PyModule_AddReadyType(pyev, "Task", &TaskType) ||
+        PyModule_AddReadyType(pyev, "Wait", &WaitType) ||
         /* additional events */
         PyModule_AddIntMacro(pyev, EV_CUSTOM) ||
         PyModule_AddIntMacro(pyev, EV_ERROR) ||
@@ -628,26 +1301,97 @@ init_pyev(void)
         PyModule_AddIntMacro(pyev, EV_MINPRI) ||
         PyModule_AddIntMacro(pyev, EV_MAXPRI)
        ) {
-        goto fail;
+        return -1;
+    }
+#ifdef PYEV_ASYNCIO_ENABLE
+    /* pyev.asyncio, empty until used, registered so that it can be imported
+       as such */
+    if (!(asyncio = Asyncio_New())) {
+        return -1;
     }
+    if (PyDict_SetItemString(PyImport_GetModuleDict(), "pyev.asyncio",
+                             asyncio) ||
+        PyModule_AddObject(pyev, "asyncio", asyncio)) {
+        Py_DECREF(asyncio);
+        return -1;
+    }
+#endif
     /* setup libev */
     ev_set_allocator(pyev_allocator);
     ev_set_syserr_cb(Py_FatalError);
-    return pyev;
+    return 0;
+}
+
 
-fail:
 #if PY_MAJOR_VERSION >= 3
-    Py_DECREF(pyev);
+#ifdef PYEV_MULTI_PHASE_INIT
+/* pyev_module.m_slots */
+static PyModuleDef_Slot pyev_m_slots[] = {
+    {Py_mod_exec, (void *)pyev_exec},
+#if PY_VERSION_HEX >= 0x030C0000
+    /* not Py_MOD_PER_INTERPRETER_GIL_SUPPORTED, the types are static */
+    {Py_mod_multiple_interpreters, Py_MOD_MULTIPLE_INTERPRETERS_SUPPORTED},
 #endif
-    return NULL;
+#if PY_VERSION_HEX >= 0x030D0000
+    {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+    {0, NULL} /* Sentinel */
+};
+#endif
+
+
+/* pyev_module */
+static PyModuleDef pyev_module = {
+    PyModuleDef_HEAD_INIT,
+    "pyev",                                   /*m_name*/
+    pyev_m_doc,                               /*m_doc*/
+#ifdef PYEV_MULTI_PHASE_INIT
+    0,                                        /*m_size*/
+    pyev_m_methods,                           /*m_methods*/
+    pyev_m_slots,                             /*m_slots*/
+#else
+    -1,                                       /*m_size*/
+    pyev_m_methods,                           /*m_methods*/
+#endif
+};
+#endif
+
+
+#ifndef PYEV_MULTI_PHASE_INIT
+/* pyev_module initialization (single-phase) */
+PyObject *
+init_pyev(void)
+{
+    /* pyev */
+    PyObject *pyev = NULL;
+#if PY_MAJOR_VERSION >= 3
+    pyev = PyModule_Create(&pyev_module);
+#else
+    pyev = Py_InitModule3("pyev", pyev_m_methods, pyev_m_doc);
+#endif
+    if (!pyev) {
+        return NULL;
+    }
+    if (pyev_exec(pyev)) {
+#if PY_MAJOR_VERSION >= 3
+        Py_DECREF(pyev);
+#endif
+        return NULL;
+    }
+    return pyev;
 }
+#endif
 
 
 #if PY_MAJOR_VERSION >= 3
 PyMODINIT_FUNC
 PyInit_pyev(void)
 {
+#ifdef PYEV_MULTI_PHASE_INIT
+    return PyModuleDef_Init(&pyev_module);
+#else
     return init_pyev();
+#endif
 }
 #else
 PyMODINIT_FUNC